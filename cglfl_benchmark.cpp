@@ -0,0 +1,424 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "generator/cglfl_generator.hpp"
+
+namespace gen = cglfl_generator;
+
+
+// Synthesizes registries that are several times larger than `gl.xml`, runs the whole pipeline on them,
+// and reports the time spent in each stage, the throughput, and the stages that scale worse than linearly.
+//
+// A registry of size N contains N copies of all commands, enums, features and extensions.
+// In every copy except the first one, all names get a suffix, and so do the feature APIs (so that each copy becomes a separate API variant).
+// The references to the renamed entities are renamed in the same way, so the copies are as valid as the original.
+// The rest of the document (types and groups) isn't copied.
+
+struct Options
+{
+    std::string xml_file = "gl.xml";
+    std::string work_dir = "output/bench"; // The synthesized registries go here.
+    std::string output_file = "bench_output.txt"; // The report is printed and written here.
+    std::vector<int> sizes = {1, 4, 16, 64};
+    int runs = 3; // The best time of this many runs is reported for each stage.
+    double threshold = 1.25; // A stage is flagged if its time grows this many times faster than the registry size.
+    double min_wall_ms = 5; // Stages faster than this (at the larger size) are too noisy to be flagged.
+    bool use_mmap = 1;
+};
+
+std::string LoadFile(const std::string &file_name)
+{
+    std::ifstream file(file_name, std::ios::binary);
+    if (!file)
+        throw gen::GeneratorError("Unable to open `" + file_name + "`.");
+    std::ostringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+std::size_t CountOccurrences(std::string_view str, std::string_view needle)
+{
+    std::size_t ret = 0;
+    for (std::size_t pos = str.find(needle); pos != str.npos; pos = str.find(needle, pos + needle.size()))
+        ret++;
+    return ret;
+}
+
+// Returns a suffix unique to a copy, made of letters only, so that it doesn't interfere with the version numbers in the API names.
+std::string CopySuffix(int index)
+{
+    std::string ret;
+    do
+    {
+        ret.insert(ret.begin(), char('a' + index % 26));
+        index /= 26;
+    }
+    while (index > 0);
+    return "_bench" + ret;
+}
+
+// Appends `suffix` to the values of all `name` attributes in `text`, and to the contents of all `<name>` tags.
+// If `rename_apis` is true, does the same to the `api` attributes.
+std::string RenameEntities(std::string_view text, const std::string &suffix, bool rename_apis)
+{
+    std::string ret;
+    ret.reserve(text.size() + text.size() / 8);
+
+    std::vector<std::pair<std::string_view, char>> patterns = {{" name=\"", '"'}, {"<name>", '<'}};
+    if (rename_apis)
+        patterns.push_back({" api=\"", '"'});
+
+    std::size_t pos = 0;
+    while (1)
+    {
+        // Find the next pattern.
+        std::size_t next = text.npos;
+        const std::pair<std::string_view, char> *next_pattern = 0;
+        for (const auto &pattern : patterns)
+        {
+            std::size_t found = text.find(pattern.first, pos);
+            if (found < next)
+            {
+                next = found;
+                next_pattern = &pattern;
+            }
+        }
+        if (!next_pattern)
+            break;
+
+        std::size_t value_end = text.find(next_pattern->second, next + next_pattern->first.size());
+        if (value_end == text.npos)
+            break;
+
+        ret.append(text, pos, value_end - pos);
+        ret += suffix;
+        pos = value_end;
+    }
+    ret.append(text, pos);
+    return ret;
+}
+
+struct Registry
+{
+    int size = 0;
+    std::string file_name;
+    std::size_t bytes = 0;
+
+    std::size_t commands = 0, enums = 0, features = 0, extensions = 0;
+
+    std::size_t Entities() const
+    {
+        return commands + enums + features + extensions;
+    }
+};
+
+// Synthesizes a registry `size` times larger than `source`, see the comment at the top of the file.
+Registry Synthesize(const std::string &source, int size, const std::string &file_name)
+{
+    // The parts that get copied. Each one is a range of the source.
+    struct Part
+    {
+        std::size_t begin = 0, end = 0;
+        bool rename_apis = 0;
+    };
+
+    auto Find = [&](std::string_view str, std::size_t from = 0)
+    {
+        std::size_t ret = source.find(str, from);
+        if (ret == source.npos)
+            throw gen::GeneratorError("Unable to synthesize a registry: `" + std::string(str) + "` not found.");
+        return ret;
+    };
+    auto FindLast = [&](std::string_view str)
+    {
+        std::size_t ret = source.rfind(str);
+        if (ret == source.npos)
+            throw gen::GeneratorError("Unable to synthesize a registry: `" + std::string(str) + "` not found.");
+        return ret + str.size();
+    };
+
+    Part enums_part{Find("<enums "), FindLast("</enums>")};
+    Part commands_part{Find(">", Find("<commands")) + 1, Find("</commands>")};
+    Part features_part{Find("<feature "), FindLast("</feature>"), 1};
+    Part extensions_part{Find("<extensions>") + 12, Find("</extensions>")};
+
+    std::vector<Part> parts = {enums_part, commands_part, features_part, extensions_part};
+    for (std::size_t i = 1; i < parts.size(); i++)
+    {
+        if (parts[i].begin < parts[i-1].end)
+            throw gen::GeneratorError("Unable to synthesize a registry: unexpected order of the top-level elements.");
+    }
+
+    std::string_view source_view = source;
+    auto PartView = [&](const Part &part){return source_view.substr(part.begin, part.end - part.begin);};
+
+    Registry ret;
+    ret.size = size;
+    ret.file_name = file_name;
+    ret.commands = CountOccurrences(PartView(commands_part), "<command>") * size;
+    ret.enums = CountOccurrences(PartView(enums_part), "<enum ") * size;
+    ret.features = CountOccurrences(PartView(features_part), "<feature ") * size;
+    ret.extensions = CountOccurrences(PartView(extensions_part), "<extension ") * size;
+
+    std::string result;
+    std::size_t pos = 0;
+    for (const Part &part : parts)
+    {
+        result.append(source_view.substr(pos, part.end - pos));
+        for (int i = 1; i < size; i++)
+        {
+            result += "\n    ";
+            result += RenameEntities(PartView(part), CopySuffix(i), part.rename_apis);
+        }
+        pos = part.end;
+    }
+    result.append(source_view.substr(pos));
+    ret.bytes = result.size();
+
+    gen::GeneratedFile file{file_name, std::move(result)};
+    gen::WriteFiles({file});
+
+    return ret;
+}
+
+void ReplaceAll(std::string &str, std::string_view from, std::string_view to)
+{
+    if (from.empty())
+        return;
+    for (std::size_t pos = str.find(from); pos != str.npos; pos = str.find(from, pos + to.size()))
+        str.replace(pos, from.size(), to);
+}
+
+// The stage names, in the order of their first appearance, and the best time of each stage for each registry size.
+struct Results
+{
+    std::vector<std::string> stage_names;
+    std::map<std::string, std::map<int, double>> wall_ms;
+
+    void Add(int size, const std::string &name, double ms)
+    {
+        auto [iter, is_new] = wall_ms.try_emplace(name);
+        if (is_new)
+            stage_names.push_back(name);
+
+        auto [size_iter, is_new_size] = iter->second.try_emplace(size, ms);
+        if (!is_new_size)
+            size_iter->second = std::min(size_iter->second, ms);
+    }
+};
+
+// Runs the whole pipeline on `registry`, and adds the time spent in each stage to `results`.
+void Run(const Registry &registry, const Options &options, Results &results)
+{
+    gen::LoadOptions load_options;
+    load_options.xml_file = registry.file_name;
+    load_options.cache_file.clear();
+    load_options.dump_dir.clear();
+    load_options.use_mmap = options.use_mmap;
+
+    gen::profile::Clear();
+
+    gen::Registry loaded = gen::Registry::Load(load_options);
+
+    // The newest desktop version, with all extensions, so that the amount of generated code grows with the registry.
+    std::vector<std::string> params = {"gl4.6", "compat"};
+    for (const std::string &extension : loaded.Extensions(loaded.Select(params)))
+        params.push_back(extension);
+    gen::Configuration config = loaded.Select(params);
+
+    std::vector<gen::GeneratedFile> files;
+    loaded.Generate(config, files);
+
+    for (gen::profile::Stage &stage : gen::profile::Stages())
+    {
+        if (!stage.finished)
+            continue;
+
+        // Make the names the same for all sizes.
+        ReplaceAll(stage.name, registry.file_name, "<registry>");
+        ReplaceAll(stage.name, config.OutputDir() + "/", "");
+
+        results.Add(registry.size, stage.name, stage.wall_ms);
+    }
+}
+
+void Report(std::ostream &out, const std::vector<Registry> &registries, const Results &results, const Options &options)
+{
+    std::size_t name_width = 5;
+    for (const std::string &name : results.stage_names)
+        name_width = std::max(name_width, name.size());
+
+    out << std::fixed;
+
+    out << "Registries:\n"
+        << std::setw(6) << "Size" << std::setw(12) << "XML, MB" << std::setw(12) << "Commands" << std::setw(12) << "Enums"
+        << std::setw(12) << "Features" << std::setw(12) << "Extensions" << std::setw(12) << "Entities" << '\n';
+    for (const Registry &registry : registries)
+    {
+        out << std::setw(5) << registry.size << 'x' << std::setprecision(2) << std::setw(12) << registry.bytes / 1e6
+            << std::setw(12) << registry.commands << std::setw(12) << registry.enums << std::setw(12) << registry.features
+            << std::setw(12) << registry.extensions << std::setw(12) << registry.Entities() << '\n';
+    }
+
+    // Throughput is relative to the size of the whole registry, even for the stages that only process a part of it.
+    out << "\nStages (best of " << options.runs << " runs):\n"
+        << std::left << std::setw(name_width) << "Stage" << std::right
+        << std::setw(6) << "Size" << std::setw(12) << "Wall, ms" << std::setw(12) << "MB/s" << std::setw(16) << "Entities/s" << '\n';
+    for (const std::string &name : results.stage_names)
+    {
+        const auto &times = results.wall_ms.at(name);
+        for (const Registry &registry : registries)
+        {
+            auto iter = times.find(registry.size);
+            if (iter == times.end())
+                continue;
+
+            double seconds = std::max(iter->second, 1e-3) / 1000;
+            out << std::left << std::setw(name_width) << (registry.size == registries.front().size ? name : "") << std::right
+                << std::setw(5) << registry.size << 'x' << std::setprecision(2) << std::setw(12) << iter->second
+                << std::setprecision(1) << std::setw(12) << registry.bytes / 1e6 / seconds
+                << std::setprecision(0) << std::setw(16) << registry.Entities() / seconds << '\n';
+        }
+    }
+
+    // The growth of the time relative to the growth of the registry. 1 is linear.
+    out << "\nScaling (time growth / size growth, flagged with `!` if above " << std::setprecision(2) << options.threshold << "):\n"
+        << std::left << std::setw(name_width) << "Stage" << std::right;
+    for (std::size_t i = 1; i < registries.size(); i++)
+        out << std::setw(14) << std::to_string(registries[i-1].size) + "x->" + std::to_string(registries[i].size) + "x";
+    out << '\n';
+
+    std::vector<std::string> flagged;
+    for (const std::string &name : results.stage_names)
+    {
+        const auto &times = results.wall_ms.at(name);
+        out << std::left << std::setw(name_width) << name << std::right;
+        bool is_flagged = 0;
+        for (std::size_t i = 1; i < registries.size(); i++)
+        {
+            auto small = times.find(registries[i-1].size), large = times.find(registries[i].size);
+            if (small == times.end() || large == times.end())
+            {
+                out << std::setw(14) << "-";
+                continue;
+            }
+
+            double ratio = std::max(large->second, 1e-3) / std::max(small->second, 1e-3) / (double(registries[i].bytes) / registries[i-1].bytes);
+            bool flag = ratio > options.threshold && large->second >= options.min_wall_ms;
+            out << std::setprecision(2) << std::setw(12) << ratio << (flag ? " !" : "  ");
+            is_flagged |= flag;
+        }
+        out << '\n';
+        if (is_flagged)
+            flagged.push_back(name);
+    }
+
+    out << '\n';
+    if (flagged.empty())
+    {
+        out << "No superlinear scaling detected.\n";
+    }
+    else
+    {
+        out << "Superlinear scaling detected in:\n";
+        for (const std::string &name : flagged)
+            out << "  " << name << '\n';
+    }
+}
+
+// Parses a comma-separated list of positive numbers.
+std::vector<int> ParseSizes(const std::string &str)
+{
+    std::vector<int> ret;
+    std::istringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ','))
+    {
+        int size = std::atoi(item.c_str());
+        if (size <= 0)
+            throw gen::GeneratorError("Invalid registry size: " + item);
+        ret.push_back(size);
+    }
+    if (ret.empty())
+        throw gen::GeneratorError("No registry sizes specified.");
+    std::sort(ret.begin(), ret.end());
+    ret.erase(std::unique(ret.begin(), ret.end()), ret.end());
+    return ret;
+}
+
+int main(int argc, char **argv) try
+{
+    Options options;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string param = argv[i];
+        if (param.compare(0, 6, "--xml=") == 0)
+            options.xml_file = param.substr(6);
+        else if (param.compare(0, 9, "--output=") == 0)
+            options.output_file = param.substr(9);
+        else if (param.compare(0, 8, "--sizes=") == 0)
+            options.sizes = ParseSizes(param.substr(8));
+        else if (param.compare(0, 7, "--runs=") == 0)
+            options.runs = std::max(1, std::atoi(param.c_str() + 7));
+        else if (param.compare(0, 12, "--threshold=") == 0)
+            options.threshold = std::atof(param.c_str() + 12);
+        else if (param == "--no-mmap")
+            options.use_mmap = 0;
+        else
+            throw gen::GeneratorError("Unknown option: " + param);
+    }
+
+    gen::profile::Enable();
+
+    std::vector<Registry> registries;
+    Results results;
+
+    {
+        std::string source = LoadFile(options.xml_file);
+
+        for (int size : options.sizes)
+        {
+            std::cout << "Synthesizing a " << size << "x registry\n";
+            registries.push_back(Synthesize(source, size, options.work_dir + "/gl_x" + std::to_string(size) + ".xml"));
+        }
+    }
+
+    for (const Registry &registry : registries)
+    {
+        for (int run = 0; run < options.runs; run++)
+        {
+            std::cout << "Running on the " << registry.size << "x registry (" << run + 1 << "/" << options.runs << ")\n";
+            Run(registry, options, results);
+        }
+    }
+
+    std::ostringstream report;
+    Report(report, registries, results, options);
+
+    std::cout << '\n' << report.str();
+
+    std::ofstream file(options.output_file);
+    file << report.str();
+    if (file)
+        std::cout << "\nWrote `" << options.output_file << "`\n";
+    else
+        std::cout << "\nWarning: Unable to write `" << options.output_file << "`.\n";
+
+    return 0;
+}
+catch (const gen::GeneratorError &e)
+{
+    std::cout << "Error: " << e.what() << '\n';
+    return 1;
+}
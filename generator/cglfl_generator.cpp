@@ -0,0 +1,5319 @@
+#define VERSION "1.0.0"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "cglfl_generator.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#  include <immintrin.h>
+#endif
+
+#ifdef _WIN32
+#  define WIN32_LEAN_AND_MEAN
+#  define NOMINMAX
+#  include <windows.h>
+#  include <psapi.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/resource.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+
+namespace cglfl_generator::impl
+{
+    namespace data
+    {
+        const std::string calling_convention_macro = "CGLFL_API";
+
+        const std::vector<std::pair<std::string, std::string>> type_replacements
+        {
+            {"signed char"   , "std::int8_t"  }, // Sic!
+            {"unsigned char" , "std::uint8_t" },
+            {"short"         , "std::int16_t" },
+            {"unsigned short", "std::uint16_t"},
+            {"int"           , "std::int32_t" },
+            {"unsigned int"  , "std::uint32_t"},
+
+            {"khronos_int8_t"  , "std::int8_t"   },
+            {"khronos_uint8_t" , "std::uint8_t"  },
+            {"khronos_int16_t" , "std::int16_t"  },
+            {"khronos_uint16_t", "std::uint16_t" },
+            {"khronos_int32_t" , "std::int32_t"  },
+            {"khronos_uint32_t", "std::uint32_t" },
+            {"khronos_int64_t" , "std::int64_t"  },
+            {"khronos_uint64_t", "std::uint64_t" },
+            {"khronos_float_t" , "float"         },
+            {"khronos_intptr_t", "std::intptr_t" },
+            {"khronos_ssize_t" , "std::ptrdiff_t"},
+        };
+
+        const std::string pragma_once = "#pragma once\n\n";
+
+        // All generated files have this line near the beginning, and live in this directory of `Configuration::OutputDir()`.
+        const std::string generated_file_marker = "// Generated, do no edit!\n";
+        const std::string generated_dir_name = "cglfl_generated";
+
+        // The names from `cglfl.hpp` that the generated module exports, from `namespace cglfl` and `namespace cglfl::debug` respectively.
+        const std::vector<const char *> module_exports = {"function_loader_t", "load", "load_extension", "load_all", "batch_function_loader_t", "load_batch",
+                                                          "load_extension_batch", "load_all_batch", "context", "context_pointer", "default_context"};
+        const std::vector<const char *> module_exports_debug = {"log_func_t", "log_func", "log", "log_calls", "log_string_params", "check_errors",
+                                                                "error_hanler_func_t", "error_handler_func", "call_glGetError", "check_errors_now", "sync_class",
+                                                                "get_sync_class", "sync_class_name", "count_sync_points", "time_sync_points", "sync_next_frame",
+                                                                "sync_report", "sync_reset", "sync_begin", "sync_end", "to_string"};
+
+        // The parameter types that are classified as handles in the reflection tables.
+        const std::set<std::string> handle_types = {"GLsync", "GLhandleARB", "GLeglImageOES", "GLeglClientBufferEXT", "GLvdpauSurfaceNV"};
+        // Same, but for `GLuint` parameters with these names. The registry doesn't mark the object names, so those are guessed.
+        const std::set<std::string> handle_param_names = {"buffer", "framebuffer", "id", "list", "memory", "path", "pipeline", "program", "queryHandle", "queryId",
+                                                          "readBuffer", "renderbuffer", "sampler", "semaphore", "shader", "texture", "vaobj", "writeBuffer", "xfb"};
+
+        // The functions that `src/cglfl.cpp` calls itself. Never dropped as unused.
+        const std::vector<std::string> runtime_functions = {"glGetError"};
+
+        // When searching directories for the used functions, only the files with these extensions are scanned.
+        const std::set<std::string> source_file_extensions = {".c", ".cc", ".cpp", ".cxx", ".c++", ".h", ".hh", ".hpp", ".hxx", ".h++", ".inl", ".ipp", ".inc", ".m", ".mm"};
+
+        // The same as `cglfl::debug::sync_class`.
+        const std::set<std::string> sync_class_names = {"none", "query", "readback", "wait", "map", "map_range"};
+        // The function name patterns for the sync classes, see `GenerateOptions::sync_classes`. A trailing `*` matches any suffix, the first match wins.
+        // The functions that don't match anything are `none`.
+        const std::vector<std::pair<std::string, std::string>> sync_class_patterns
+        {
+            {"glFinish*"                , "wait"     },
+            {"glClientWait*"            , "wait"     },
+            {"glMapBufferRange*"        , "map_range"},
+            {"glMapNamedBufferRange*"   , "map_range"},
+            {"glMapBuffer*"             , "map"      },
+            {"glMapNamedBuffer*"        , "map"      },
+            {"glMapObjectBuffer*"       , "map"      },
+            {"glMapTexture*"            , "map"      },
+            {"glReadPixels*"            , "readback" },
+            {"glReadnPixels*"           , "readback" },
+            {"glGetTexImage*"           , "readback" },
+            {"glGetnTexImage*"          , "readback" },
+            {"glGetTextureImage*"       , "readback" },
+            {"glGetTextureSubImage*"    , "readback" },
+            {"glGetCompressedTexImage*" , "readback" },
+            {"glGetnCompressedTexImage*", "readback" },
+            {"glGetCompressedTexture*"  , "readback" },
+            {"glGetBufferSubData*"      , "readback" },
+            {"glGetNamedBufferSubData*" , "readback" },
+            {"glGetQueryObject*"        , "readback" },
+            {"glGet*"                   , "query"    },
+            {"glIs*"                    , "query"    },
+            {"glAre*"                   , "query"    },
+            {"glCheck*"                 , "query"    },
+            {"glTestFence*"             , "query"    },
+            {"glTestObject*"            , "query"    },
+        };
+    }
+
+    template <typename ...P> std::string Str(const P &... params)
+    {
+        std::ostringstream stream;
+        (stream << ... << params);
+        return stream.str();
+    }
+
+    // Throws `GeneratorError`, see `cglfl_generator.hpp`.
+    [[noreturn]] void Error(std::string message)
+    {
+        throw GeneratorError(message);
+    }
+
+    std::string GetContext(const char *ptr, const char *end)
+    {
+        std::string ret;
+        int n = 30;
+        while (ptr < end && *ptr && n-- > 0)
+            ret += *ptr++;
+        return ret;
+    }
+
+
+    // A fixed set of worker threads, running tasks in the order they were added.
+    class ThreadPool
+    {
+        std::vector<std::thread> threads;
+        std::deque<std::function<void()>> queue;
+        std::mutex mutex;
+        std::condition_variable condition;
+        bool stopping = 0;
+
+      public:
+        explicit ThreadPool(int thread_count)
+        {
+            for (int i = 0; i < thread_count; i++)
+            {
+                threads.emplace_back([this]
+                {
+                    while (1)
+                    {
+                        std::function<void()> task;
+                        {
+                            std::unique_lock lock(mutex);
+                            condition.wait(lock, [&]{return stopping || queue.size() > 0;});
+                            if (queue.empty())
+                                return;
+                            task = std::move(queue.front());
+                            queue.pop_front();
+                        }
+                        task();
+                    }
+                });
+            }
+        }
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        // Waits for all queued tasks to finish.
+        ~ThreadPool()
+        {
+            {
+                std::lock_guard lock(mutex);
+                stopping = 1;
+            }
+            condition.notify_all();
+            for (auto &thread : threads)
+                thread.join();
+        }
+
+        // Exceptions thrown by the task are rethrown by `get()` on the returned future.
+        template <typename F>
+        auto Run(F &&func) -> std::future<decltype(func())>
+        {
+            auto task = std::make_shared<std::packaged_task<decltype(func())()>>(std::forward<F>(func));
+            auto ret = task->get_future();
+            {
+                std::lock_guard lock(mutex);
+                queue.push_back([task]{(*task)();});
+            }
+            condition.notify_one();
+            return ret;
+        }
+
+        // The default number of threads.
+        static int DefaultThreadCount()
+        {
+            return std::max(1u, std::thread::hardware_concurrency());
+        }
+    };
+
+    // Per-stage timing and memory usage, enabled by `--profile`.
+    // Since some stages can run in parallel, CPU time and allocation counts are process-wide, and include all threads.
+    // Peak RSS is the high-water mark at the end of the stage.
+    namespace Profile
+    {
+        namespace impl
+        {
+            std::uint64_t (*allocation_count)() = 0;
+        }
+
+        struct Sample
+        {
+            std::chrono::steady_clock::time_point wall_time;
+            double cpu_seconds = 0;
+            std::uint64_t allocations = 0;
+            std::uint64_t peak_rss_kib = 0;
+
+            static Sample Now()
+            {
+                Sample ret;
+                ret.wall_time = std::chrono::steady_clock::now();
+                ret.allocations = impl::allocation_count ? impl::allocation_count() : 0;
+                #ifdef _WIN32
+                FILETIME creation, exit, kernel, user;
+                if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+                {
+                    auto Seconds = [](FILETIME time){return ((std::uint64_t(time.dwHighDateTime) << 32) | time.dwLowDateTime) / 1e7;};
+                    ret.cpu_seconds = Seconds(kernel) + Seconds(user);
+                }
+                PROCESS_MEMORY_COUNTERS counters;
+                if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof counters))
+                    ret.peak_rss_kib = counters.PeakWorkingSetSize / 1024;
+                #else
+                rusage usage;
+                if (getrusage(RUSAGE_SELF, &usage) == 0)
+                {
+                    ret.cpu_seconds = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+                    #ifdef __APPLE__
+                    ret.peak_rss_kib = usage.ru_maxrss / 1024; // Bytes on MacOS, KiB elsewhere.
+                    #else
+                    ret.peak_rss_kib = usage.ru_maxrss;
+                    #endif
+                }
+                #endif
+                return ret;
+            }
+        };
+
+        struct Stage
+        {
+            std::string name;
+            bool finished = 0;
+            double wall_ms = 0;
+            double cpu_ms = 0;
+            std::uint64_t allocations = 0;
+            std::uint64_t peak_rss_kib = 0;
+
+            void SetFromSamples(const Sample &begin, const Sample &end)
+            {
+                finished = 1;
+                wall_ms = std::chrono::duration<double, std::milli>(end.wall_time - begin.wall_time).count();
+                cpu_ms = (end.cpu_seconds - begin.cpu_seconds) * 1000;
+                allocations = end.allocations - begin.allocations;
+                peak_rss_kib = end.peak_rss_kib;
+            }
+        };
+
+        namespace impl
+        {
+            bool enabled = 0;
+            Sample start;
+
+            std::mutex mutex;
+            std::deque<Stage> stages; // A deque, to keep references stable.
+        }
+
+        void Enable(std::uint64_t (*allocation_count)())
+        {
+            impl::allocation_count = allocation_count;
+            impl::enabled = 1;
+            impl::start = Sample::Now();
+        }
+
+        bool IsEnabled()
+        {
+            return impl::enabled;
+        }
+
+        // Returns copies of the stages recorded so far.
+        std::vector<Stage> Stages()
+        {
+            std::lock_guard<std::mutex> lock(impl::mutex);
+            return std::vector<Stage>(impl::stages.begin(), impl::stages.end());
+        }
+
+        // Forgets the recorded stages, and restarts the total time. Must not be called while any stages are running.
+        void Clear()
+        {
+            std::lock_guard<std::mutex> lock(impl::mutex);
+            impl::stages.clear();
+            impl::start = Sample::Now();
+        }
+
+        // Records a stage from construction to destruction. Does nothing if profiling is disabled.
+        // The stages are reported in the order they were started.
+        class Scope
+        {
+            Stage *stage = 0;
+            Sample begin;
+
+          public:
+            Scope(std::string name)
+            {
+                if (!impl::enabled)
+                    return;
+                {
+                    std::lock_guard<std::mutex> lock(impl::mutex);
+                    stage = &impl::stages.emplace_back();
+                    stage->name = std::move(name);
+                }
+                begin = Sample::Now();
+            }
+
+            Scope(const Scope &) = delete;
+            Scope &operator=(const Scope &) = delete;
+
+            ~Scope()
+            {
+                if (!stage)
+                    return;
+                Sample end = Sample::Now();
+                std::lock_guard<std::mutex> lock(impl::mutex);
+                stage->SetFromSamples(begin, end);
+            }
+        };
+
+        std::string JsonString(std::string_view str)
+        {
+            std::string ret = "\"";
+            for (char ch : str)
+            {
+                if (ch == '"' || ch == '\\')
+                    ret += '\\';
+                if ((unsigned char)ch < ' ')
+                {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof buffer, "\\u%04x", ch);
+                    ret += buffer;
+                    continue;
+                }
+                ret += ch;
+            }
+            ret += '"';
+            return ret;
+        }
+
+        // Prints a table of all stages to `out`, and writes the same data to `json_file_name` as JSON.
+        void Report(std::ostream &out, const std::string &json_file_name)
+        {
+            std::lock_guard<std::mutex> lock(impl::mutex);
+
+            Stage total;
+            total.name = "Total";
+            total.SetFromSamples(impl::start, Sample::Now());
+
+            std::size_t name_width = total.name.size();
+            for (const Stage &stage : impl::stages)
+                name_width = std::max(name_width, stage.name.size());
+
+            auto PrintRow = [&](const Stage &stage)
+            {
+                out << std::left << std::setw(name_width) << stage.name << std::right;
+                if (!stage.finished)
+                {
+                    out << "  (not finished)\n";
+                    return;
+                }
+                out << std::fixed << std::setprecision(2)
+                    << std::setw(12) << stage.wall_ms
+                    << std::setw(12) << stage.cpu_ms
+                    << std::setw(14) << stage.allocations
+                    << std::setw(16) << stage.peak_rss_kib << '\n';
+            };
+
+            std::ios old_format(nullptr);
+            old_format.copyfmt(out);
+
+            out << "\nProfile:\n"
+                << std::left << std::setw(name_width) << "Stage" << std::right
+                << std::setw(12) << "Wall, ms"
+                << std::setw(12) << "CPU, ms"
+                << std::setw(14) << "Allocations"
+                << std::setw(16) << "Peak RSS, KiB" << '\n';
+            for (const Stage &stage : impl::stages)
+                PrintRow(stage);
+            PrintRow(total);
+            out.copyfmt(old_format);
+
+            std::filesystem::path path = json_file_name;
+            std::error_code error;
+            if (path.has_parent_path())
+                std::filesystem::create_directories(path.parent_path(), error);
+
+            std::ofstream file(json_file_name);
+            auto WriteStage = [&](const Stage &stage)
+            {
+                file << "{\"name\": " << JsonString(stage.name) << ", \"finished\": " << (stage.finished ? "true" : "false")
+                    << ", \"wall_ms\": " << stage.wall_ms << ", \"cpu_ms\": " << stage.cpu_ms
+                    << ", \"allocations\": " << stage.allocations << ", \"peak_rss_kib\": " << stage.peak_rss_kib << "}";
+            };
+            file << std::fixed << std::setprecision(3) << "{\n    \"version\": \"" VERSION "\",\n    \"allocations_counted\": " << (impl::allocation_count ? "true" : "false") << ",\n    \"stages\": [";
+            for (const Stage &stage : impl::stages)
+            {
+                file << (&stage == &impl::stages.front() ? "\n        " : ",\n        ");
+                WriteStage(stage);
+            }
+            file << "\n    ],\n    \"total\": ";
+            WriteStage(total);
+            file << "\n}\n";
+
+            if (file)
+                out << "Wrote `" << json_file_name << "`\n";
+            else
+                out << "Warning: Unable to write `" << json_file_name << "`.\n";
+        }
+    }
+
+    std::string LoadFile(std::string file_name)
+    {
+        std::string source;
+
+        FILE *file = std::fopen(file_name.c_str(), "rb");
+
+        if (!file)
+            Error(Str("Unable to open `", file_name, "`."));
+
+        std::fseek(file, 0, SEEK_END);
+        auto size = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+
+        if (std::ferror(file) || size == EOF)
+            Error(Str("Unable to get size of file `", file_name, "`."));
+
+        source.resize(size);
+        if (size > 0 && !std::fread(source.data(), size, 1, file))
+            Error(Str("Unable to read from file `", file_name, "`."));
+
+        std::fclose(file);
+
+        return source;
+    }
+
+    // Writes `data` to a temporary file, and then renames it over `file_name`, so that a partially written file is never observed.
+    // Creates the parent directories if needed. Returns false on failure.
+    bool WriteFileAtomically(const std::string &file_name, std::string_view data)
+    {
+        std::filesystem::path path = file_name;
+        std::error_code error;
+        if (path.has_parent_path())
+            std::filesystem::create_directories(path.parent_path(), error);
+
+        // Unique per process and per call, so that concurrent writers never share a temporary file.
+        static std::atomic<unsigned> temp_file_counter{0};
+        #ifdef _WIN32
+        unsigned long process_id = GetCurrentProcessId();
+        #else
+        unsigned long process_id = getpid();
+        #endif
+        std::string temp_file_name = Str(file_name, ".", process_id, ".", temp_file_counter.fetch_add(1, std::memory_order_relaxed), ".tmp");
+
+        {
+            std::ofstream file(temp_file_name, std::ios::binary);
+            if (!file)
+                return 0;
+            file.write(data.data(), data.size());
+            file.close();
+            if (!file)
+            {
+                std::filesystem::remove(temp_file_name, error);
+                return 0;
+            }
+        }
+
+        std::filesystem::rename(temp_file_name, file_name, error);
+        if (error)
+        {
+            std::filesystem::remove(temp_file_name, error);
+            return 0;
+        }
+        return 1;
+    }
+
+    // A read-only view of a file contents.
+    // Memory-maps the file if possible, otherwise (or if `use_mmap == false`) falls back to `LoadFile`.
+    class SourceFile
+    {
+        std::string_view view;
+        std::string loaded; // Used only if the file wasn't mapped.
+
+        #ifdef _WIN32
+        HANDLE file_handle = INVALID_HANDLE_VALUE, mapping_handle = 0;
+        #endif
+        void *mapping = 0;
+        std::size_t mapping_size = 0;
+
+        bool TryMap(const std::string &file_name)
+        {
+            #ifdef _WIN32
+            file_handle = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+            if (file_handle == INVALID_HANDLE_VALUE)
+                return 0;
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file_handle, &size) || size.QuadPart == 0)
+                return 0;
+            mapping_handle = CreateFileMappingA(file_handle, 0, PAGE_READONLY, 0, 0, 0);
+            if (!mapping_handle)
+                return 0;
+            mapping = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+            if (!mapping)
+                return 0;
+            mapping_size = size.QuadPart;
+            #else
+            int fd = open(file_name.c_str(), O_RDONLY);
+            if (fd == -1)
+                return 0;
+            struct stat info;
+            if (fstat(fd, &info) || info.st_size == 0)
+            {
+                close(fd);
+                return 0;
+            }
+            void *ptr = mmap(0, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd); // The mapping stays valid after closing the descriptor.
+            if (ptr == MAP_FAILED)
+                return 0;
+            madvise(ptr, info.st_size, MADV_SEQUENTIAL);
+            mapping = ptr;
+            mapping_size = info.st_size;
+            #endif
+
+            view = std::string_view((const char *)mapping, mapping_size);
+            return 1;
+        }
+
+        void Unmap()
+        {
+            #ifdef _WIN32
+            if (mapping)
+                UnmapViewOfFile(mapping);
+            if (mapping_handle)
+                CloseHandle(mapping_handle);
+            if (file_handle != INVALID_HANDLE_VALUE)
+                CloseHandle(file_handle);
+            file_handle = INVALID_HANDLE_VALUE;
+            mapping_handle = 0;
+            #else
+            if (mapping)
+                munmap(mapping, mapping_size);
+            #endif
+            mapping = 0;
+            mapping_size = 0;
+        }
+
+      public:
+        SourceFile() {}
+
+        SourceFile(std::string file_name, bool use_mmap = 1)
+        {
+            if (use_mmap && TryMap(file_name))
+                return;
+            Unmap();
+            loaded = LoadFile(file_name);
+            view = loaded;
+        }
+
+        SourceFile(const SourceFile &) = delete;
+        SourceFile &operator=(const SourceFile &) = delete;
+
+        ~SourceFile()
+        {
+            Unmap();
+        }
+
+        bool IsMapped() const
+        {
+            return mapping != 0;
+        }
+
+        std::string_view View() const
+        {
+            return view;
+        }
+    };
+
+
+    // Kernels for the hot searches in `LexSource`.
+    // All of them return `end` if nothing is found. A whitespace is a character in range `1..32` (signed), same as in `LexSource`.
+    namespace Scan
+    {
+        namespace scalar
+        {
+            const char *FindByte(const char *ptr, const char *end, char byte)
+            {
+                while (ptr < end && *ptr != byte)
+                    ptr++;
+                return ptr;
+            }
+
+            const char *SkipWhitespace(const char *ptr, const char *end)
+            {
+                while (ptr < end && *ptr > '\0' && *ptr <= ' ')
+                    ptr++;
+                return ptr;
+            }
+
+            // Finds the next `<`, `&`, or whitespace.
+            const char *FindTextSpecial(const char *ptr, const char *end)
+            {
+                while (ptr < end && *ptr != '<' && *ptr != '&' && !(*ptr > '\0' && *ptr <= ' '))
+                    ptr++;
+                return ptr;
+            }
+        }
+
+        #if defined(__x86_64__) || defined(_M_X64)
+        #define CGLFL_SCAN_X86 1
+
+        // Each function processes whole blocks, and then finishes the tail with the scalar version.
+        namespace sse2
+        {
+            inline int FirstBit(unsigned mask)
+            {
+                #ifdef _MSC_VER
+                unsigned long ret;
+                _BitScanForward(&ret, mask);
+                return ret;
+                #else
+                return __builtin_ctz(mask);
+                #endif
+            }
+
+            const char *FindByte(const char *ptr, const char *end, char byte)
+            {
+                const __m128i needle = _mm_set1_epi8(byte);
+                for (; end - ptr >= 16; ptr += 16)
+                {
+                    __m128i block = _mm_loadu_si128((const __m128i *)ptr);
+                    if (unsigned mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)))
+                        return ptr + FirstBit(mask);
+                }
+                return scalar::FindByte(ptr, end, byte);
+            }
+
+            inline __m128i WhitespaceMask(__m128i block)
+            {
+                return _mm_and_si128(_mm_cmpgt_epi8(block, _mm_setzero_si128()), _mm_cmplt_epi8(block, _mm_set1_epi8(' ' + 1)));
+            }
+
+            const char *SkipWhitespace(const char *ptr, const char *end)
+            {
+                for (; end - ptr >= 16; ptr += 16)
+                {
+                    __m128i block = _mm_loadu_si128((const __m128i *)ptr);
+                    if (unsigned mask = ~unsigned(_mm_movemask_epi8(WhitespaceMask(block))) & 0xffff)
+                        return ptr + FirstBit(mask);
+                }
+                return scalar::SkipWhitespace(ptr, end);
+            }
+
+            const char *FindTextSpecial(const char *ptr, const char *end)
+            {
+                for (; end - ptr >= 16; ptr += 16)
+                {
+                    __m128i block = _mm_loadu_si128((const __m128i *)ptr);
+                    __m128i special = _mm_or_si128(WhitespaceMask(block), _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8('<')), _mm_cmpeq_epi8(block, _mm_set1_epi8('&'))));
+                    if (unsigned mask = _mm_movemask_epi8(special))
+                        return ptr + FirstBit(mask);
+                }
+                return scalar::FindTextSpecial(ptr, end);
+            }
+        }
+
+        #if defined(__GNUC__)
+        #define CGLFL_SCAN_AVX2 1
+        #define CGLFL_SCAN_TARGET_AVX2 __attribute__((__target__("avx2")))
+
+        namespace avx2
+        {
+            CGLFL_SCAN_TARGET_AVX2 const char *FindByte(const char *ptr, const char *end, char byte)
+            {
+                const __m256i needle = _mm256_set1_epi8(byte);
+                for (; end - ptr >= 32; ptr += 32)
+                {
+                    __m256i block = _mm256_loadu_si256((const __m256i *)ptr);
+                    if (unsigned mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block, needle)))
+                        return ptr + sse2::FirstBit(mask);
+                }
+                return sse2::FindByte(ptr, end, byte);
+            }
+
+            CGLFL_SCAN_TARGET_AVX2 inline __m256i WhitespaceMask(__m256i block)
+            {
+                return _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_setzero_si256()), _mm256_cmpgt_epi8(_mm256_set1_epi8(' ' + 1), block));
+            }
+
+            CGLFL_SCAN_TARGET_AVX2 const char *SkipWhitespace(const char *ptr, const char *end)
+            {
+                for (; end - ptr >= 32; ptr += 32)
+                {
+                    __m256i block = _mm256_loadu_si256((const __m256i *)ptr);
+                    if (unsigned mask = ~unsigned(_mm256_movemask_epi8(WhitespaceMask(block))))
+                        return ptr + sse2::FirstBit(mask);
+                }
+                return sse2::SkipWhitespace(ptr, end);
+            }
+
+            CGLFL_SCAN_TARGET_AVX2 const char *FindTextSpecial(const char *ptr, const char *end)
+            {
+                for (; end - ptr >= 32; ptr += 32)
+                {
+                    __m256i block = _mm256_loadu_si256((const __m256i *)ptr);
+                    __m256i special = _mm256_or_si256(WhitespaceMask(block), _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8('<')), _mm256_cmpeq_epi8(block, _mm256_set1_epi8('&'))));
+                    if (unsigned mask = _mm256_movemask_epi8(special))
+                        return ptr + sse2::FirstBit(mask);
+                }
+                return sse2::FindTextSpecial(ptr, end);
+            }
+        }
+        #endif
+        #endif
+
+        struct Kernels
+        {
+            const char *name;
+            bool (*is_supported)();
+            const char *(*find_byte)(const char *ptr, const char *end, char byte);
+            const char *(*skip_whitespace)(const char *ptr, const char *end);
+            const char *(*find_text_special)(const char *ptr, const char *end);
+
+            // Finds a string, returns `end` if not found.
+            const char *FindString(const char *ptr, const char *end, std::string_view str) const
+            {
+                while (1)
+                {
+                    ptr = find_byte(ptr, end, str.front());
+                    if (std::size_t(end - ptr) < str.size())
+                        return end;
+                    if (!std::memcmp(ptr, str.data(), str.size()))
+                        return ptr;
+                    ptr++;
+                }
+            }
+        };
+
+        // From the narrowest to the widest.
+        const std::vector<Kernels> &AllKernels()
+        {
+            static const std::vector<Kernels> ret
+            {
+                {"scalar", []{return true;}, scalar::FindByte, scalar::SkipWhitespace, scalar::FindTextSpecial},
+                #if CGLFL_SCAN_X86
+                {"sse2", []{return true;}, sse2::FindByte, sse2::SkipWhitespace, sse2::FindTextSpecial},
+                #endif
+                #if CGLFL_SCAN_AVX2
+                {"avx2", []{__builtin_cpu_init(); return bool(__builtin_cpu_supports("avx2"));}, avx2::FindByte, avx2::SkipWhitespace, avx2::FindTextSpecial},
+                #endif
+            };
+            return ret;
+        }
+
+        // Returns null if there are no such kernels, or if they're not supported by the CPU.
+        const Kernels *FindKernels(std::string_view name)
+        {
+            for (const Kernels &kernels : AllKernels())
+            {
+                if (kernels.name == name)
+                    return kernels.is_supported() ? &kernels : nullptr;
+            }
+            return nullptr;
+        }
+
+        // The kernels used by default. Initially those are the widest supported ones.
+        const Kernels *current = []{
+            const Kernels *ret = 0;
+            for (const Kernels &kernels : AllKernels())
+            {
+                if (kernels.is_supported())
+                    ret = &kernels;
+            }
+            return ret;
+        }();
+    }
+
+
+    struct Token
+    {
+        enum Type
+        {
+            text, tag_begin, tag_end, tag_terse,
+        };
+
+        struct Attribute
+        {
+            std::string_view name;
+            std::string_view value;
+        };
+
+        Type type;
+        std::string_view value; // Points either into the source, or into `TokenList::strings`.
+        std::vector<Attribute> attributes; // In the same order as in the source.
+    };
+
+    // Lexes the source, calling `func(const Token &)` for each token as soon as it's scanned.
+    // The token is reused between calls, so the callback should copy it if it needs it later.
+    // Token strings point either into `source` or into `strings` (the text that had to be unescaped or normalized),
+    // both of which must outlive them. It's a list, so that the views stay valid when it grows or is spliced into another list.
+    template <typename F>
+    void LexSource(std::string_view source, std::list<std::string> &strings, F &&func, const Scan::Kernels &scan = *Scan::current)
+    {
+        const std::string_view
+            header_begin  = "<?",
+            header_end    = "?>",
+            comment_begin = "<!--",
+            comment_end   = "-->";
+
+        struct EscapePair
+        {
+            std::string_view from;
+            char to;
+        };
+        static constexpr EscapePair escape_pairs[]
+        {
+            { "lt;"  , '<' },
+            { "gt;"  , '>' },
+            { "amp;" , '&' },
+            { "apos;", '\''},
+            { "quot;", '"' },
+        };
+
+        // The input ends at the first null character, if any.
+        source = source.substr(0, source.find('\0'));
+
+        const char *ptr = source.data(), *const end = ptr + source.size();
+
+        Token token;
+
+        auto Cur = [&]() -> char
+        {
+            return ptr < end ? *ptr : '\0';
+        };
+        auto IsSpace = [](char ch) -> bool
+        {
+            return ch > '\0' && ch <= ' ';
+        };
+        auto IsNameChar = [](char ch) -> bool
+        {
+            return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+        };
+        auto SkipWhitespace = [&]
+        {
+            ptr = scan.skip_whitespace(ptr, end);
+        };
+        auto StartsWith = [&](const char *pos, std::string_view str) -> bool
+        {
+            return std::size_t(end - pos) >= str.size() && !std::memcmp(pos, str.data(), str.size());
+        };
+        auto SkipPast = [&](std::string_view terminator)
+        {
+            ptr = scan.FindString(ptr, end, terminator);
+            if (ptr == end)
+                Error(Str("Expected `", terminator, "` at the end of input."));
+            ptr += terminator.size();
+        };
+
+        while (ptr < end)
+        {
+            // Skip whitespace
+            SkipWhitespace();
+
+            // Skip header
+            if (StartsWith(ptr, header_begin))
+            {
+                ptr += header_begin.size();
+                SkipPast(header_end);
+                continue;
+            }
+
+            // Skip comment
+            if (StartsWith(ptr, comment_begin))
+            {
+                ptr += comment_begin.size();
+                SkipPast(comment_end);
+                continue;
+            }
+
+            // Parse tag
+            if (Cur() == '<')
+            {
+                ptr++;
+
+                Token &new_token = token;
+                new_token.attributes.clear();
+
+                // Skip whitespace after `<`.
+                SkipWhitespace();
+
+                bool closing_tag = 0;
+
+                if (Cur() == '/')
+                {
+                    closing_tag = 1;
+                    ptr++;
+
+                    // Skip whitespace after `/`.
+                    SkipWhitespace();
+                }
+
+                // Read tag name.
+                const char *name_begin = ptr;
+                while (IsNameChar(Cur()))
+                    ptr++;
+                new_token.value = std::string_view(name_begin, ptr - name_begin);
+
+                // Stop if no name.
+                if (new_token.value.empty())
+                    Error(Str("Missing tag name. Context:\n", GetContext(ptr, end)));
+
+                // Skip whitespace after tag name.
+                SkipWhitespace();
+
+                // Get tag type, parse attributes if needed.
+                if (closing_tag)
+                {
+                    new_token.type = Token::tag_end;
+                }
+                else
+                {
+                    // Parse attributes
+                    while (Cur() != '>' && Cur() != '/')
+                    {
+                        Token::Attribute attribute;
+
+                        // Read attribute name.
+                        const char *attr_name_begin = ptr;
+                        while (IsNameChar(Cur()))
+                            ptr++;
+                        attribute.name = std::string_view(attr_name_begin, ptr - attr_name_begin);
+
+                        // Stop if no name.
+                        if (attribute.name.empty())
+                            Error(Str("Missing attribute name. Context:\n", GetContext(ptr, end)));
+
+                        // Skip whitespace after attribute name.
+                        SkipWhitespace();
+
+                        // Stop if no `=` sign.
+                        if (Cur() != '=')
+                            Error(Str("Missing `=` after attribute name. Context:\n", GetContext(ptr, end)));
+                        ptr++;
+
+                        // Skip whitespace after `=`.
+                        SkipWhitespace();
+
+                        // Stop if no opening `"`.
+                        if (Cur() != '"')
+                            Error(Str("Missing opening `\"` in attribute. Context:\n", GetContext(ptr, end)));
+                        ptr++;
+
+                        // Read attribute value.
+                        const char *value_begin = ptr;
+                        ptr = scan.find_byte(ptr, end, '"');
+                        attribute.value = std::string_view(value_begin, ptr - value_begin);
+
+                        // Stop if no terminating `"`.
+                        if (ptr == end)
+                            Error(Str("Expected closing `\"` at the end of input."));
+                        else
+                            ptr++;
+
+                        // Skip whitespace after attribute value.
+                        SkipWhitespace();
+
+                        // Add attribute to the list.
+                        new_token.attributes.push_back(attribute);
+                    }
+
+                    // Check if it's a terse tag.
+                    if (Cur() != '/')
+                    {
+                        new_token.type = Token::tag_begin;
+                    }
+                    else
+                    {
+                        ptr++;
+                        new_token.type = Token::tag_terse;
+
+                        // Skip whitespace after `/`.
+                        SkipWhitespace();
+                    }
+                }
+
+                // Stop if no '>'.
+                if (Cur() != '>')
+                    Error(Str("Missing `>` in a tag. Context:\n", GetContext(ptr, end)));
+                ptr++;
+
+                func(std::as_const(new_token));
+                continue;
+            }
+
+            { // Read plain text
+                // First try to use the text as is. This works if it has no escapes,
+                // and all whitespace runs in it are single spaces or line feeds (trailing whitespace is dropped anyway).
+                const char *text_begin = ptr, *text_end = ptr;
+                bool needs_copy = 0;
+                while (1)
+                {
+                    // Skip to the next `<`, `&`, or whitespace.
+                    if (const char *next = scan.find_text_special(ptr, end); next != ptr)
+                        ptr = text_end = next;
+
+                    if (ptr == end || *ptr == '<')
+                        break;
+
+                    if (*ptr == '&')
+                    {
+                        needs_copy = 1;
+                        ptr++;
+                        text_end = ptr;
+                    }
+                    else
+                    {
+                        const char *run_begin = ptr;
+                        SkipWhitespace();
+                        if (ptr - run_begin != 1 || (*run_begin != ' ' && *run_begin != '\n'))
+                            needs_copy = 1; // This is wrong for trailing whitespace, but it doesn't matter.
+                    }
+                }
+
+                if (text_end == text_begin)
+                    continue;
+
+                Token &new_token = token;
+                new_token.type = Token::text;
+                new_token.attributes.clear();
+
+                if (!needs_copy)
+                {
+                    new_token.value = std::string_view(text_begin, text_end - text_begin);
+                }
+                else
+                {
+                    std::string new_text;
+                    for (const char *cur = text_begin; cur < text_end;)
+                    {
+                        if (IsSpace(*cur))
+                        {
+                            if (new_text.size() > 0 && new_text.back() != ' ' && new_text.back() != '\n')
+                                new_text.push_back(*cur == '\n' || *cur == '\r' ? '\n' : ' ');
+                            else if (new_text.size() > 0 && new_text.back() == ' ' && *cur == '\n')
+                                new_text.back() = '\n';
+                            cur++;
+                        }
+                        else if (*cur == '&')
+                        {
+                            cur++;
+
+                            bool found = 0;
+                            for (const auto &pair : escape_pairs)
+                            {
+                                if (StartsWith(cur, pair.from))
+                                {
+                                    found = 1;
+                                    new_text += pair.to;
+                                    cur += pair.from.size();
+                                    break;
+                                }
+                            }
+
+                            if (!found)
+                                Error(Str("Unknown escape sequence. Context:\n", GetContext(cur-1, end)));
+                        }
+                        else
+                        {
+                            new_text += *cur++;
+                        }
+                    }
+
+                    new_token.value = strings.emplace_back(std::move(new_text));
+                }
+
+                func(std::as_const(new_token));
+            }
+        }
+    }
+
+    struct TokenList
+    {
+        std::vector<Token> tokens;
+        std::list<std::string> strings; // See `LexSource` above.
+    };
+
+    bool operator==(const Token &a, const Token &b)
+    {
+        if (a.type != b.type || a.value != b.value || a.attributes.size() != b.attributes.size())
+            return 0;
+        for (std::size_t i = 0; i < a.attributes.size(); i++)
+        {
+            if (a.attributes[i].name != b.attributes[i].name || a.attributes[i].value != b.attributes[i].value)
+                return 0;
+        }
+        return 1;
+    }
+
+    // The returned tokens point into `source`, which must outlive them.
+    TokenList LexSource(std::string_view source, const Scan::Kernels &scan = *Scan::current)
+    {
+        TokenList ret;
+        LexSource(source, ret.strings, [&](const Token &token)
+        {
+            ret.tokens.push_back(token);
+        }, scan);
+        return ret;
+    }
+
+    // Finds the positions of `<` that begin tags at the top level of the root tag (i.e. at depth 1), outside of comments and headers.
+    // Lexing can be safely split at any of them.
+    std::vector<const char *> FindTopLevelTags(std::string_view source, const Scan::Kernels &scan = *Scan::current)
+    {
+        std::vector<const char *> ret;
+
+        const char *ptr = source.data(), *const end = ptr + source.size();
+        int depth = 0;
+
+        auto SkipPast = [&](std::string_view terminator)
+        {
+            ptr = scan.FindString(ptr, end, terminator);
+            ptr = ptr == end ? end : ptr + terminator.size();
+        };
+
+        while ((ptr = scan.find_byte(ptr, end, '<')) != end)
+        {
+            const char *tag_begin = ptr++;
+
+            if (ptr == end)
+                Error(Str("Missing tag name at the end of input."));
+
+            if (*ptr == '?')
+            {
+                SkipPast("?>");
+                continue;
+            }
+            if (end - ptr >= 3 && std::string_view(ptr, 3) == "!--")
+            {
+                SkipPast("-->");
+                continue;
+            }
+
+            const char *after_whitespace = scan.skip_whitespace(ptr, end);
+            bool closing = after_whitespace < end && *after_whitespace == '/';
+
+            // Find the end of the tag, skipping attribute values, since they can contain `>`.
+            const char *last_non_whitespace = 0;
+            while (ptr < end && *ptr != '>')
+            {
+                if (*ptr == '"')
+                    ptr = scan.find_byte(ptr + 1, end, '"');
+                else if (!(*ptr > '\0' && *ptr <= ' '))
+                    last_non_whitespace = ptr;
+                if (ptr < end)
+                    ptr++;
+            }
+
+            if (closing)
+            {
+                depth--;
+            }
+            else if (!last_non_whitespace || *last_non_whitespace != '/')
+            {
+                if (depth == 1)
+                    ret.push_back(tag_begin);
+                depth++;
+            }
+        }
+
+        return ret;
+    }
+
+    // Same as `LexSource`, but splits the source into `chunk_count` (or less) chunks at top-level tags,
+    // and lexes them in parallel. The result is the same as for the sequential version.
+    TokenList LexSourceParallel(std::string_view source, ThreadPool &pool, int chunk_count, const Scan::Kernels &scan = *Scan::current)
+    {
+        // The input ends at the first null character, if any. (This is also checked by `LexSource`.)
+        source = source.substr(0, source.find('\0'));
+
+        // Choose the split points, roughly evenly.
+        std::vector<const char *> split_points = {source.data()};
+        {
+            std::vector<const char *> candidates = FindTopLevelTags(source, scan);
+            auto it = candidates.begin();
+            for (int i = 1; i < chunk_count; i++)
+            {
+                const char *target = source.data() + source.size() / chunk_count * i;
+                it = std::lower_bound(it, candidates.end(), target);
+                if (it == candidates.end())
+                    break;
+                if (*it != split_points.back())
+                    split_points.push_back(*it);
+            }
+        }
+        split_points.push_back(source.data() + source.size());
+
+        std::vector<std::future<TokenList>> chunks;
+        for (std::size_t i = 0; i + 1 < split_points.size(); i++)
+        {
+            std::string_view chunk(split_points[i], split_points[i+1] - split_points[i]);
+            chunks.push_back(pool.Run([chunk, &scan]{return LexSource(chunk, scan);}));
+        }
+
+        // Stitch the chunks together. If several chunks fail, the error from the first one is reported.
+        TokenList ret;
+        std::vector<TokenList> results;
+        for (auto &chunk : chunks)
+            results.push_back(chunk.get());
+
+        std::size_t token_count = 0;
+        for (const TokenList &result : results)
+            token_count += result.tokens.size();
+        ret.tokens.reserve(token_count);
+
+        for (TokenList &result : results)
+        {
+            ret.tokens.insert(ret.tokens.end(), std::make_move_iterator(result.tokens.begin()), std::make_move_iterator(result.tokens.end()));
+            ret.strings.splice(ret.strings.end(), result.strings);
+        }
+
+        return ret;
+    }
+
+
+    // Allocates objects in large blocks, and frees all of them at once.
+    // Objects are never moved, even when the arena itself is moved.
+    class Arena
+    {
+        static constexpr std::size_t block_size = 1 << 16;
+
+        std::vector<std::unique_ptr<char[]>> blocks;
+        char *pos = 0;
+        std::size_t bytes_left = 0;
+
+        void *AllocateBytes(std::size_t size, std::size_t alignment)
+        {
+            std::size_t padding = -std::uintptr_t(pos) & (alignment - 1);
+            if (!pos || padding + size > bytes_left)
+            {
+                std::size_t new_block_size = std::max(block_size, size + alignment);
+                blocks.push_back(std::make_unique<char[]>(new_block_size));
+                pos = blocks.back().get();
+                bytes_left = new_block_size;
+                padding = -std::uintptr_t(pos) & (alignment - 1);
+            }
+
+            void *ret = pos + padding;
+            pos += padding + size;
+            bytes_left -= padding + size;
+            return ret;
+        }
+
+      public:
+        // Destructors are never called, so the type has to be trivially destructible.
+        template <typename T> T *Allocate(std::size_t count = 1)
+        {
+            static_assert(std::is_trivially_destructible_v<T>, "Destructors of arena objects are never called.");
+            T *ret = static_cast<T *>(AllocateBytes(sizeof(T) * count, alignof(T)));
+            for (std::size_t i = 0; i < count; i++)
+                new(ret + i) T{};
+            return ret;
+        }
+
+        std::string_view CopyString(std::string_view str)
+        {
+            char *ret = static_cast<char *>(AllocateBytes(str.size(), 1));
+            std::copy(str.begin(), str.end(), ret);
+            return std::string_view(ret, str.size());
+        }
+    };
+
+    // Stores a single copy of each string, so that interned strings can be compared by address.
+    class StringInterner
+    {
+        Arena storage;
+        std::unordered_set<std::string_view> strings;
+
+      public:
+        std::string_view Intern(std::string_view str)
+        {
+            if (auto it = strings.find(str); it != strings.end())
+                return *it;
+            return *strings.insert(storage.CopyString(str)).first;
+        }
+    };
+
+    // A non-owning view of an array.
+    template <typename T>
+    struct ArrayView
+    {
+        T *data = 0;
+        std::size_t count = 0;
+
+        T *begin() const {return data;}
+        T *end() const {return data + count;}
+        std::size_t size() const {return count;}
+        bool empty() const {return count == 0;}
+        T &front() const {return data[0];}
+        T &back() const {return data[count-1];}
+        T &operator[](std::size_t i) const {return data[i];}
+    };
+
+    // A XML node. Those are allocated in an arena, owned by a `Document`.
+    struct Element
+    {
+        struct Attribute
+        {
+            std::string_view name; // Interned.
+            std::string_view value;
+        };
+
+        // A forward list of child elements.
+        struct ChildList
+        {
+            struct Iterator
+            {
+                const Element *elem = 0;
+
+                const Element &operator*() const {return *elem;}
+                const Element *operator->() const {return elem;}
+                Iterator &operator++() {elem = elem->next_sibling; return *this;}
+                bool operator==(const Iterator &other) const {return elem == other.elem;}
+                bool operator!=(const Iterator &other) const {return elem != other.elem;}
+            };
+
+            const Element *first = 0;
+            int count = 0;
+
+            Iterator begin() const {return {first};}
+            Iterator end() const {return {};}
+            std::size_t size() const {return count;}
+            bool empty() const {return count == 0;}
+            const Element &front() const {return *first;}
+        };
+
+        // All child tags with the same name. See `TreeBuilder::IndexChild()`.
+        struct ChildGroup
+        {
+            std::string_view name; // Interned.
+            const Element *first = 0; // The rest are linked with `next_namesake`.
+            int count = 0;
+        };
+
+        bool is_tag = 1;
+        std::string_view value; // Text or tag name. Tag names are interned.
+        const Element *parent = 0; // Null for the root element.
+        const Element *next_sibling = 0;
+        const Element *next_namesake = 0; // The next sibling tag with the same name.
+        int index = 0; // Index of this element in its parent, counting the elements discarded by `TreeBuilder` too.
+
+        // Tag only:
+        ArrayView<const Attribute> attributes; // Sorted by name, without duplicates.
+        ChildList elements;
+        ArrayView<const ChildGroup> child_groups; // Sorted by name.
+
+        void PrettyPrint(std::ostream &stream, int indent = 0) const
+        {
+            std::string ind(indent * 4, ' ');
+            stream << ind;
+            for (char ch : value)
+            {
+                stream << ch;
+                if (ch == '\n')
+                    stream << ind;
+            }
+            if (is_tag)
+            {
+                for (const auto &attr : attributes)
+                    stream << " [" << attr.name << '=' << attr.value << ']';
+                if (value.size() > 0)
+                    stream << ' ';
+                stream << '{';
+                if (elements.size() > 0)
+                {
+                    stream << '\n';
+                    for (const auto &child : elements)
+                        child.PrettyPrint(stream, indent+1);
+                    stream << ind;
+                }
+                stream << '}';
+            }
+            stream << '\n';
+        }
+
+        std::string FullName() const // This walks all parents, so use it only for error messages.
+        {
+            std::vector<const Element *> parents;
+            for (const Element *elem = parent; elem; elem = elem->parent)
+            {
+                if (!elem->value.empty())
+                    parents.push_back(elem);
+            }
+
+            std::string ret;
+            for (auto it = parents.rbegin(); it != parents.rend(); it++)
+                ret += Str((*it)->value, "(", (*it)->index, ")/");
+            ret += is_tag ? value : "<text>";
+            return ret;
+        }
+
+        bool IsTagNamed(std::string_view name) const
+        {
+            return is_tag && value == name;
+        }
+
+        const ChildGroup *FindChildGroup(std::string_view name) const // If there are no child tags with this name, returns null.
+        {
+            auto it = std::lower_bound(child_groups.begin(), child_groups.end(), name, [](const ChildGroup &group, std::string_view name){return group.name < name;});
+            if (it != child_groups.end() && it->name == name)
+                return it;
+            return 0;
+        }
+
+        const Element &GetChild(std::string_view name) const
+        {
+            const ChildGroup *group = FindChildGroup(name);
+            if (!group)
+                Error(Str("No element named `", name, "` in `", FullName(), "`."));
+            if (group->count > 1)
+                Error(Str("Several elements named `", name, "` in `", FullName(), "`, but expected only one."));
+            return *group->first;
+        }
+
+        template <typename F> void ForEachChildNamed(std::string_view name, F &&func) const // Generates a error if it's a text node.
+        {
+            if (!is_tag)
+                Error(Str("Expected `", FullName(), "` to be a tag rather than a text."));
+
+            if (const ChildGroup *group = FindChildGroup(name))
+            {
+                for (const Element *elem = group->first; elem; elem = elem->next_namesake)
+                    func(*elem);
+            }
+        }
+
+        std::string_view GetTextNodeText() const // If it's a text node, returns the contents. Otherwise generates a error.
+        {
+            if (is_tag)
+                Error(Str("Expected `", FullName(), "` to be a text node."));
+            return value;
+        }
+
+        std::string_view GetContainedText() const // If it's a text node, returns the contents. If it's a tag, it has to have a single text node in it, which contents will be returned. Otherwise generates a error.
+        {
+            if (!is_tag)
+                return value;
+            if (elements.size() != 1 || elements.front().is_tag)
+                Error(Str("Expected `", FullName(), "` to be a text node or a tag with a single text node in it."));
+            return elements.front().value;
+        }
+
+        const Attribute *FindAttribute(std::string_view name) const // If it's a text node, returns null.
+        {
+            for (const auto &attr : attributes)
+                if (attr.name == name)
+                    return &attr;
+            return 0;
+        }
+
+        bool HasAttribute(std::string_view name) const // If it's a text node, returns 0.
+        {
+            return FindAttribute(name);
+        }
+
+        std::string_view GetAttribute(std::string_view name) const // If no such attribute, generates a error.
+        {
+            if (auto attr = FindAttribute(name))
+                return attr->value;
+            else
+                Error(Str("Expected an attribute named `", name, "` in `", FullName(), "`."));
+        }
+
+        bool HasAttributeEqualTo(std::string_view name, std::string_view value) const // If the node has no such attribute (possibly because it's a text node), returns 0.
+        {
+            if (auto attr = FindAttribute(name))
+                return attr->value == value;
+            else
+                return 0;
+        }
+    };
+
+    // Owns a tree of elements.
+    // Attribute values and text point into the source the document was parsed from, which must outlive the document.
+    struct Document
+    {
+        Arena arena;
+        StringInterner names; // Tag and attribute names.
+        std::list<std::string> strings; // The text that had to be unescaped, see `LexSource`.
+        const Element *root = 0; // The root element is nameless, the actual root tag is its child.
+
+        const Element &Root() const
+        {
+            return *root;
+        }
+    };
+
+    // Builds a `Document` from tokens, one token at a time.
+    // If `subtrees` are specified (as `/`-separated paths from the root, e.g. `registry/commands`),
+    // only the tags matching them (with all their contents) and their ancestors (without any other contents) are kept.
+    // The rest of the document is only checked for correct nesting.
+    class TreeBuilder
+    {
+        struct StackEntry
+        {
+            Element *elem;
+            Element *last_child;
+            int child_count; // Counting the discarded children too.
+            bool keep_all; // If false, we're in an ancestor of some of the subtrees.
+            std::size_t groups_begin; // Index of the first child group of this element in `group_buffer`.
+        };
+
+        struct GroupEntry
+        {
+            Element::ChildGroup group;
+            Element *last;
+        };
+
+        std::vector<std::vector<std::string_view>> subtrees;
+        Document document;
+        std::vector<StackEntry> stack;
+        std::vector<std::string_view> discarded_stack; // Names of the unclosed discarded tags.
+        std::vector<Element::Attribute> attribute_buffer;
+        std::vector<GroupEntry> group_buffer; // Child groups of all elements in `stack`. Only the last element can get new groups.
+
+        // Returns 0 if the tag should be discarded, 1 if it should be kept as an ancestor of a subtree, 2 if it should be kept with all contents.
+        int ClassifyTag(std::string_view name) const
+        {
+            if (stack.back().keep_all)
+                return 2;
+
+            std::size_t depth = stack.size() - 1; // Depth of the new tag, minus one. The root element doesn't count.
+            int ret = 0;
+            for (const auto &path : subtrees)
+            {
+                if (path.size() <= depth || path[depth] != name)
+                    continue;
+                bool match = 1;
+                for (std::size_t i = 0; i < depth; i++)
+                {
+                    if (path[i] != stack[i+1].elem->value)
+                    {
+                        match = 0;
+                        break;
+                    }
+                }
+                if (!match)
+                    continue;
+                if (path.size() == depth + 1)
+                    return 2;
+                ret = 1;
+            }
+            return ret;
+        }
+
+        Element &AddChild(int index)
+        {
+            auto &parent = stack.back();
+
+            Element &obj = *document.arena.Allocate<Element>();
+            obj.parent = parent.elem;
+            obj.index = index;
+
+            if (parent.last_child)
+                parent.last_child->next_sibling = &obj;
+            else
+                parent.elem->elements.first = &obj;
+            parent.last_child = &obj;
+            parent.elem->elements.count++;
+
+            return obj;
+        }
+
+        // Adds a new child tag of the last element in the stack to its child index.
+        void IndexChild(Element &child)
+        {
+            for (std::size_t i = stack.back().groups_begin; i < group_buffer.size(); i++)
+            {
+                GroupEntry &entry = group_buffer[i];
+                if (entry.group.name.data() == child.value.data()) // The names are interned, so comparing the pointers is enough.
+                {
+                    entry.last->next_namesake = &child;
+                    entry.last = &child;
+                    entry.group.count++;
+                    return;
+                }
+            }
+            group_buffer.push_back({{child.value, &child, 1}, &child});
+        }
+
+        // Saves the child index of the last element in the stack. Call this before popping it.
+        void FinishChildIndex()
+        {
+            const StackEntry &entry = stack.back();
+
+            std::size_t count = group_buffer.size() - entry.groups_begin;
+            if (count > 0)
+            {
+                Element::ChildGroup *groups = document.arena.Allocate<Element::ChildGroup>(count);
+                for (std::size_t i = 0; i < count; i++)
+                    groups[i] = group_buffer[entry.groups_begin + i].group;
+                std::sort(groups, groups + count, [](const Element::ChildGroup &a, const Element::ChildGroup &b){return a.name < b.name;});
+                entry.elem->child_groups = {groups, count};
+            }
+
+            group_buffer.resize(entry.groups_begin);
+        }
+
+      public:
+        TreeBuilder(const std::vector<std::string_view> &subtree_paths = {})
+        {
+            for (std::string_view path : subtree_paths)
+            {
+                auto &parts = subtrees.emplace_back();
+                while (1)
+                {
+                    auto pos = path.find('/');
+                    parts.push_back(path.substr(0, pos));
+                    if (pos == std::string_view::npos)
+                        break;
+                    path.remove_prefix(pos+1);
+                }
+            }
+
+            // There is no danger of ending the root tag, since empty tag names are catched earlier.
+            Element *root = document.arena.Allocate<Element>();
+            document.root = root;
+            stack.push_back({root, 0, 0, subtrees.empty(), 0});
+        }
+
+        // Use this to store the text that had to be unescaped. See `LexSource`.
+        std::list<std::string> &Strings()
+        {
+            return document.strings;
+        }
+
+        void operator()(const Token &token)
+        {
+            if (discarded_stack.size() > 0)
+            {
+                if (token.type == Token::tag_begin)
+                {
+                    discarded_stack.push_back(token.value);
+                }
+                else if (token.type == Token::tag_end)
+                {
+                    if (token.value != discarded_stack.back())
+                        Error(Str("Closing tag `</", token.value, ">` has no matching opening tag."));
+                    discarded_stack.pop_back();
+                }
+                return;
+            }
+
+            switch (token.type)
+            {
+              case Token::tag_begin:
+              case Token::tag_terse:
+                {
+                    int index = stack.back().child_count++;
+
+                    int mode = ClassifyTag(token.value);
+                    if (mode == 0)
+                    {
+                        if (token.type != Token::tag_terse)
+                            discarded_stack.push_back(token.value);
+                        break;
+                    }
+
+                    Element &obj = AddChild(index);
+                    obj.is_tag = 1;
+                    obj.value = document.names.Intern(token.value);
+                    IndexChild(obj);
+
+                    // Sort the attributes by name, keeping only the first one of each name.
+                    attribute_buffer.clear();
+                    for (const auto &attr : token.attributes)
+                        attribute_buffer.push_back({document.names.Intern(attr.name), attr.value});
+                    std::stable_sort(attribute_buffer.begin(), attribute_buffer.end(), [](const Element::Attribute &a, const Element::Attribute &b){return a.name < b.name;});
+                    attribute_buffer.erase(std::unique(attribute_buffer.begin(), attribute_buffer.end(), [](const Element::Attribute &a, const Element::Attribute &b){return a.name == b.name;}), attribute_buffer.end());
+
+                    if (attribute_buffer.size() > 0)
+                    {
+                        Element::Attribute *attributes = document.arena.Allocate<Element::Attribute>(attribute_buffer.size());
+                        std::copy(attribute_buffer.begin(), attribute_buffer.end(), attributes);
+                        obj.attributes = {attributes, attribute_buffer.size()};
+                    }
+
+                    if (token.type != Token::tag_terse)
+                        stack.push_back({&obj, 0, 0, mode == 2, group_buffer.size()});
+                }
+                break;
+              case Token::tag_end:
+                {
+                    if (token.value != stack.back().elem->value)
+                        Error(Str("Closing tag `</", token.value, ">` has no matching opening tag."));
+                    FinishChildIndex();
+                    stack.pop_back();
+                }
+                break;
+              case Token::text:
+                {
+                    int index = stack.back().child_count++;
+                    if (!stack.back().keep_all)
+                        break;
+
+                    Element &obj = AddChild(index);
+                    obj.is_tag = 0;
+                    obj.value = token.value;
+                }
+                break;
+              default:
+                Error("Invalid token type. (Internal error.)");
+                break;
+            }
+        }
+
+        Document Finish()
+        {
+            if (discarded_stack.size() > 0)
+                Error(Str("Missing closing tag </", discarded_stack.back(), "> in ", stack.back().elem->FullName(), "."));
+            if (stack.size() > 1) // Note the 1. The stack shouldn't be empty, because it always has the root element in it.
+                Error(Str("Missing closing tag </", stack.back().elem->value, "> for ", stack.back().elem->FullName(), "."));
+
+            FinishChildIndex(); // For the root element.
+            return std::move(document);
+        }
+    };
+
+    // The tokens are consumed, because the resulting document takes ownership of their unescaped strings.
+    Document ParseTokens(TokenList token_list)
+    {
+        TreeBuilder builder;
+        builder.Strings() = std::move(token_list.strings);
+        for (const auto &token : token_list.tokens)
+            builder(token);
+        return builder.Finish();
+    }
+
+    // Lexes and parses the source in one pass, without storing the tokens. See `TreeBuilder` for the meaning of `subtrees`.
+    Document ParseSource(std::string_view source, const std::vector<std::string_view> &subtrees = {})
+    {
+        TreeBuilder builder(subtrees);
+        LexSource(source, builder.Strings(), builder);
+        return builder.Finish();
+    }
+
+
+    // The parts of the document used by `ExtractTypes`, see `TreeBuilder`.
+    const std::vector<std::string_view> types_subtrees = {"registry/types"};
+
+    struct TypeData
+    {
+        std::string code; // The type definitions.
+        std::vector<std::string> names; // The names of the defined types, in order, without duplicates.
+    };
+
+    TypeData ExtractTypes(const Element &root_element)
+    {
+        std::string ret;
+        std::vector<std::string> names;
+
+        // Get the types.
+        const auto &loc = root_element.GetChild("registry").GetChild("types");
+        for (const auto &elem : loc.elements)
+        {
+            if (!elem.IsTagNamed("type"))
+                Error(Str("Expected `", loc.FullName(), "` to consist only of `type` tags."));
+
+            // Discard silly includes.
+            if (elem.HasAttributeEqualTo("name", "stddef") || elem.HasAttributeEqualTo("name", "khrplatform"))
+                continue;
+
+            // Get the name, either from the attribute or from the `<name>` tag. The attribute can also be e.g. `struct _cl_context`.
+            std::string name(elem.HasAttribute("name") ? elem.GetAttribute("name") : elem.GetChild("name").GetContainedText());
+            name.erase(0, name.rfind(' ') + 1);
+            if (std::find(names.begin(), names.end(), name) == names.end())
+                names.push_back(std::move(name));
+
+            // Add the type.
+            for (const auto &elem : elem.elements)
+            {
+                if (elem.IsTagNamed("apientry"))
+                {
+                    ret += data::calling_convention_macro;
+                    continue;
+                }
+
+                std::string text(elem.GetContainedText());
+
+                if (ret.size() > 0 && ret.back() != '*' && ret.back() != '\n' && text.front() != ';' && text.front() != ')') // We don't need to check text emptiness, it always has a positive size.
+                    ret += ' ';
+
+                ret += text;
+            }
+            ret += '\n';
+        }
+
+        { // Tweak the types.
+            { // Add spaces after commas for better looks.
+                std::string new_ret;
+                for (std::size_t i = 0; i < ret.size(); i++)
+                {
+                    if (ret[i] == ',' && ret[i+1] != ' ')
+                        new_ret += ", ";
+                    else
+                        new_ret += ret[i];
+                }
+                ret = std::move(new_ret);
+            }
+
+            { // Replace builtin types (and `khronos_*_t` types) with standard fixed-width aliases.
+                std::string new_ret;
+                const char *ptr = ret.c_str();
+
+                while (*ptr)
+                {
+                    bool found = 0;
+                    bool dont_replace = ptr == ret.c_str() || (ptr[-1] >= 'A' && ptr[-1] <= 'Z') || (ptr[-1] >= 'a' && ptr[-1] <= 'z') || (ptr[-1] >= '0' && ptr[-1] <= '9') || ptr[-1] == '_';
+                    if (!dont_replace)
+                    {
+                        for (const auto &pair : data::type_replacements)
+                        {
+                            if (!std::strncmp(ptr, pair.first.c_str(), pair.first.size()))
+                            {
+                                found = 1;
+                                ptr += pair.first.size();
+                                new_ret += pair.second;
+                                break;
+                            }
+                        }
+                    }
+                    if (!found)
+                        new_ret += *ptr++;
+                }
+
+                ret = std::move(new_ret);
+            }
+        }
+
+        return {std::move(ret), std::move(names)};
+    }
+
+
+    // A set of symbol IDs (see `SymbolTable`), stored as a sorted vector.
+    // Used for the small sets stored in the registry, since a `SymbolSet` is as large as the largest ID in it, and the IDs of related symbols can be far apart.
+    class SymbolList
+    {
+        std::vector<int> ids;
+
+      public:
+        SymbolList() {}
+        // `ids` must be sorted, without duplicates.
+        SymbolList(std::vector<int> ids) : ids(std::move(ids)) {}
+
+        // `ids` can be in any order, and can contain duplicates.
+        static SymbolList FromUnsorted(std::vector<int> ids)
+        {
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+            return ids;
+        }
+
+        const std::vector<int> &Ids() const
+        {
+            return ids;
+        }
+
+        bool Contains(int id) const
+        {
+            return std::binary_search(ids.begin(), ids.end(), id);
+        }
+
+        void Insert(int id)
+        {
+            auto it = std::lower_bound(ids.begin(), ids.end(), id);
+            if (it == ids.end() || *it != id)
+                ids.insert(it, id);
+        }
+
+        std::size_t size() const
+        {
+            return ids.size();
+        }
+
+        bool empty() const
+        {
+            return ids.empty();
+        }
+
+        SymbolList &operator|=(const SymbolList &other)
+        {
+            if (other.empty())
+                return *this;
+            std::vector<int> result;
+            result.reserve(ids.size() + other.ids.size());
+            std::set_union(ids.begin(), ids.end(), other.ids.begin(), other.ids.end(), std::back_inserter(result));
+            ids = std::move(result);
+            return *this;
+        }
+
+        // Removes all elements of `other` from this set.
+        SymbolList &operator-=(const SymbolList &other)
+        {
+            if (other.empty())
+                return *this;
+            ids.erase(std::remove_if(ids.begin(), ids.end(), [&](int id){return other.Contains(id);}), ids.end());
+            return *this;
+        }
+
+        // Calls `func(id)` for each element, in ascending order.
+        template <typename F> void ForEach(F &&func) const
+        {
+            for (int id : ids)
+                func(id);
+        }
+    };
+
+    // A set of symbol IDs (see `SymbolTable`), stored as a bitset. Set operations work on whole words.
+    class SymbolSet
+    {
+        std::vector<std::uint64_t> words;
+
+        static int FirstBit(std::uint64_t word)
+        {
+            #ifdef _MSC_VER
+            unsigned long ret;
+            _BitScanForward64(&ret, word);
+            return ret;
+            #else
+            return __builtin_ctzll(word);
+            #endif
+        }
+
+        static int BitCount(std::uint64_t word)
+        {
+            word = word - ((word >> 1) & 0x5555555555555555);
+            word = (word & 0x3333333333333333) + ((word >> 2) & 0x3333333333333333);
+            word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0f;
+            return (word * 0x0101010101010101) >> 56;
+        }
+
+      public:
+        SymbolSet() {}
+
+        bool Contains(int id) const
+        {
+            std::size_t index = id / 64;
+            return index < words.size() && (words[index] >> (id % 64) & 1);
+        }
+
+        void Insert(int id)
+        {
+            std::size_t index = id / 64;
+            if (index >= words.size())
+                words.resize(index + 1);
+            words[index] |= std::uint64_t(1) << (id % 64);
+        }
+
+        std::size_t size() const
+        {
+            std::size_t ret = 0;
+            for (std::uint64_t word : words)
+                ret += BitCount(word);
+            return ret;
+        }
+
+        bool empty() const
+        {
+            for (std::uint64_t word : words)
+                if (word)
+                    return 0;
+            return 1;
+        }
+
+        SymbolSet &operator|=(const SymbolSet &other)
+        {
+            if (other.words.size() > words.size())
+                words.resize(other.words.size());
+            for (std::size_t i = 0; i < other.words.size(); i++)
+                words[i] |= other.words[i];
+            return *this;
+        }
+
+        SymbolSet &operator|=(const SymbolList &other)
+        {
+            if (other.empty())
+                return *this;
+            std::size_t size = other.Ids().back() / 64 + 1;
+            if (size > words.size())
+                words.resize(size);
+            for (int id : other.Ids())
+                words[id / 64] |= std::uint64_t(1) << (id % 64);
+            return *this;
+        }
+
+        // Removes all elements that are not in `other`.
+        SymbolSet &operator&=(const SymbolSet &other)
+        {
+            if (words.size() > other.words.size())
+                words.resize(other.words.size());
+            for (std::size_t i = 0; i < words.size(); i++)
+                words[i] &= other.words[i];
+            return *this;
+        }
+
+        // Removes all elements of `other` from this set.
+        SymbolSet &operator-=(const SymbolSet &other)
+        {
+            for (std::size_t i = 0; i < std::min(words.size(), other.words.size()); i++)
+                words[i] &= ~other.words[i];
+            return *this;
+        }
+
+        // Calls `func(id)` for each element, in ascending order.
+        template <typename F> void ForEach(F &&func) const
+        {
+            for (std::size_t i = 0; i < words.size(); i++)
+            {
+                for (std::uint64_t word = words[i]; word; word &= word - 1)
+                    func(int(i * 64 + FirstBit(word)));
+            }
+        }
+    };
+
+    // Assigns dense IDs to names.
+    // The IDs follow the alphabetical order, so `SymbolSet::ForEach()` visits the names in the same order as `std::set<std::string>` would.
+    class SymbolTable
+    {
+        std::vector<std::string> names;
+
+      public:
+        SymbolTable() {}
+        SymbolTable(std::vector<std::string> new_names) : names(std::move(new_names))
+        {
+            std::sort(names.begin(), names.end());
+            names.erase(std::unique(names.begin(), names.end()), names.end());
+        }
+
+        const std::vector<std::string> &Names() const
+        {
+            return names;
+        }
+
+        std::size_t size() const
+        {
+            return names.size();
+        }
+
+        const std::string &Name(int id) const
+        {
+            return names[id];
+        }
+
+        // Returns -1 if there's no such name.
+        int Find(std::string_view name) const
+        {
+            auto it = std::lower_bound(names.begin(), names.end(), name, [](const std::string &a, std::string_view b){return a < b;});
+            if (it == names.end() || *it != name)
+                return -1;
+            return it - names.begin();
+        }
+
+        int Get(std::string_view name) const // If there's no such name, generates a error.
+        {
+            int ret = Find(name);
+            if (ret == -1)
+                Error(Str("Internal: Symbol `", name, "` not found."));
+            return ret;
+        }
+
+        // Prints the names of the elements of `set` (a `SymbolSet` or a `SymbolList`), each prefixed with a space.
+        template <typename S> void PrintSet(std::ostream &stream, const S &set) const
+        {
+            set.ForEach([&](int id){stream << ' ' << names[id];});
+        }
+    };
+
+
+    struct EnumConstant
+    {
+        std::string name;
+        std::string value;
+        std::string suffix; // Number literal suffix, optional.
+        uint64_t value_number; // Some of the constants are 64-bit, for special purposes.
+        bool negative;
+    };
+
+    struct EnumGroup
+    {
+        std::string name; // Can be empty.
+        std::vector<EnumConstant> elements;
+    };
+
+    struct EnumData
+    {
+        std::vector<EnumGroup> groups;
+        std::map<std::string, std::set<std::string>> categories;
+        int max_name_len;
+        std::map<std::string, std::pair<int, int>> name_to_indices;
+
+        int enum_count;
+
+        // Updates `name_to_indices` and `enum_count` from `groups`.
+        void UpdateIndices()
+        {
+            enum_count = 0;
+            for (const EnumGroup &group : groups)
+                enum_count += group.elements.size();
+
+            name_to_indices.clear();
+            for (std::size_t i = 0; i < groups.size(); i++)
+            for (std::size_t j = 0; j < groups[i].elements.size(); j++)
+            {
+                const EnumConstant &enum_const = groups[i].elements[j];
+                if (!name_to_indices.insert({enum_const.name, {i, j}}).second)
+                    Error(Str("The spec has two enum constants named `", enum_const.name, "`."));
+            }
+        }
+
+        void PrettyPrint(std::ostream &stream) const
+        {
+            std::string ret;
+
+            { // Max name length.
+                stream << "max_name_len = " << max_name_len << '\n';
+            }
+
+            { // Categories.
+                stream << "categories {\n";
+                for (const auto &category : categories)
+                {
+                    stream << "    " << category.first << " {\n";
+                    for (const auto &elem : category.second)
+                        stream << "        " << elem << '\n';
+                    stream << "    }\n";
+                }
+                stream << "}\n";
+            }
+
+            { // Groups.
+                stream << "groups {\n";
+                for (const auto &group : groups)
+                {
+                    stream << "    " << (group.name.empty() ? "<nameless group>" : group.name) << " {\n";
+                    for (const auto &elem : group.elements)
+                    {
+                        std::string name = elem.name, type = elem.suffix;
+                        name.resize(max_name_len, ' ');
+                        type.resize(6, ' ');
+                        stream << "        [ type = " << type << ", neg = " << elem.negative << ", name = " << name << ", value = " << elem.value << ", parsed_value = " << elem.value_number << " ]\n";
+                    }
+                    stream << "    }\n";
+                }
+
+                stream << "}\n";
+            }
+        }
+    };
+
+    // The parts of the document used by `ExtractEnums`, see `TreeBuilder`.
+    const std::vector<std::string_view> enums_subtrees = {"registry/groups", "registry/enums"};
+
+    EnumData ExtractEnums(const Element &root_element)
+    {
+        EnumData enum_data;
+        enum_data.max_name_len = 0;
+
+        // Extract categories.
+        root_element.GetChild("registry").GetChild("groups").ForEachChildNamed("group", [&](const Element &elem)
+        {
+            std::string name(elem.GetAttribute("name"));
+
+            std::set<std::string> contents;
+            elem.ForEachChildNamed("enum", [&](const Element &elem)
+            {
+                contents.emplace(elem.GetAttribute("name"));
+            });
+
+            if (contents.empty())
+                return;
+
+            enum_data.categories.insert({std::move(name), std::move(contents)});
+        });
+
+        std::set<std::string> name_set;
+
+        // Extract groups.
+        root_element.GetChild("registry").ForEachChildNamed("enums", [&](const Element &elem)
+        {
+            // Construct the group.
+            enum_data.groups.push_back({});
+            auto &this_group = enum_data.groups.back();
+
+            // Get this group name
+            this_group.name = (elem.HasAttribute("group") ? elem.GetAttribute("group") : "");
+
+            // Get the constants.
+            elem.ForEachChildNamed("enum", [&](const Element &elem)
+            {
+                // Skip if it's not a real enum.
+                if (elem.HasAttribute("comment") && elem.GetAttribute("comment").find("Not an API enum.") != std::string_view::npos)
+                    return;
+
+                // Construct the element.
+                this_group.elements.push_back({});
+                auto &this_element = this_group.elements.back();
+
+                // Get name.
+                this_element.name = elem.GetAttribute("name");
+
+                // Delete this element if it's a duplicate
+                if (!name_set.insert(this_element.name).second)
+                {
+                    this_group.elements.pop_back();
+                    return;
+                }
+
+                // Get value.
+                this_element.value = elem.GetAttribute("value");
+                this_element.negative = this_element.value.front() == '-';
+
+                // Get type.
+                if (elem.HasAttribute("type"))
+                    this_element.suffix = elem.GetAttribute("type");
+
+                // Parse value.
+                char *end;
+                if (this_element.negative)
+                    this_element.value_number = std::strtoll(this_element.value.c_str(), &end, 0);
+                else
+                    this_element.value_number = std::strtoull(this_element.value.c_str(), &end, 0);
+
+                // Stop on parse failure.
+                if (end == this_element.value.c_str())
+                    Error(Str("Enum constant `", this_element.name, "` has a value that can't be parsed."));
+
+                // Update max name length.
+                if (int(this_element.name.size()) > enum_data.max_name_len)
+                    enum_data.max_name_len = this_element.name.size();
+            });
+
+            // Delete the group if it turned out to be empty.
+            if (this_group.elements.empty())
+                enum_data.groups.pop_back();
+        });
+
+        enum_data.UpdateIndices();
+
+        return enum_data;
+    }
+
+
+    struct FunctionParam
+    {
+        std::string type_l;
+        std::string type_r;
+        std::string name;
+        std::string category; // Can be empty.
+        std::string len; // The size of the array that this parameter points to, e.g. `count*4` or `COMPSIZE(pname)`. Can be empty.
+
+        // The name of the `cglfl::reflection::param_kind` enumerator for this parameter.
+        std::string_view Kind() const
+        {
+            std::string type = type_l + type_r;
+            std::size_t pointer_pos = type.find_first_of("*[");
+
+            if (pointer_pos == std::string::npos)
+            {
+                if (type == "GLenum" || type == "GLbitfield")
+                    return "enumeration";
+                if (data::handle_types.count(type) || (type == "GLuint" && data::handle_param_names.count(name)))
+                    return "handle";
+                return "scalar";
+            }
+
+            // If the pointer is `const`, then the function only reads from it.
+            if (type.compare(0, 6, "const ") != 0)
+                return "out_pointer";
+
+            std::string pointee = type.substr(6, pointer_pos - 6);
+            while (pointee.size() > 0 && pointee.back() == ' ')
+                pointee.pop_back();
+            if ((pointee == "GLchar" || pointee == "GLcharARB") && type.find_first_of("*[", pointer_pos + 1) == std::string::npos)
+                return "string";
+
+            return "in_pointer";
+        }
+    };
+
+    struct Function
+    {
+        std::string name;
+        std::string return_type;
+        std::vector<FunctionParam> params;
+
+        bool NeedSpaceAfterReturnType() const
+        {
+            return return_type.size() > 0 && return_type.back() != '*';
+        }
+
+        // The return type for `CGLFL_CALL`. `void *` is spelled as `GLvoid *`, otherwise `CGLFL_IMPL_NOT_VOID` would mistake it for `void`.
+        std::string MacroReturnType() const
+        {
+            if (return_type.size() > 4 && return_type.compare(0, 4, "void") == 0)
+                return "GL" + return_type;
+            return return_type;
+        }
+
+        enum class ParamMode {full, types_only, names_only};
+
+        std::string ParameterList(ParamMode mode, bool spaces_after_commas = 0) const
+        {
+            std::string ret;
+
+            bool first = 1;
+            for (const FunctionParam &param : params)
+            {
+                if (first)
+                {
+                    first = 0;
+                }
+                else
+                {
+                    ret += ',';
+                    if (spaces_after_commas)
+                        ret += ' ';
+                }
+
+                if (mode != ParamMode::names_only)
+                    ret += param.type_l;
+                if (mode != ParamMode::types_only)
+                {
+                    if (mode != ParamMode::names_only && ret.size() > 0 && ret.back() != '*')
+                        ret += ' ';
+                    ret += param.name;
+                }
+                if (mode != ParamMode::names_only)
+                    ret += param.type_r;
+            }
+
+            return ret;
+        }
+
+        operator std::string() const
+        {
+            return name;
+        }
+
+        friend bool operator<(const std::string &a, const std::string &b)
+        {
+            return a < b;
+        }
+    };
+
+    struct FunctionData
+    {
+        std::set<Function, std::less<>> functions;
+
+        void PrettyPrint(std::ostream &stream) const
+        {
+            stream << "functions {\n";
+
+            for (const auto &func : functions)
+            {
+                stream << "    " << func.name << " : " << func.return_type << " (\n";
+
+                for (const auto &param : func.params)
+                {
+                    stream << "        " << param.name << " : " << param.type_l;
+                    if (param.type_r.size())
+                        stream << "|" << param.type_r;
+                    if (param.category.size() > 0)
+                        stream << " (" << param.category << ')';
+                    if (param.len.size() > 0)
+                        stream << " [" << param.len << ']';
+                    stream << '\n';
+                }
+
+                stream << "    }\n";
+            }
+
+            stream << "}\n";
+        }
+    };
+
+    // The parts of the document used by `ExtractFunctions`, see `TreeBuilder`.
+    const std::vector<std::string_view> functions_subtrees = {"registry/commands"};
+
+    FunctionData ExtractFunctions(const Element &root_element)
+    {
+        const auto &loc = root_element.GetChild("registry").GetChild("commands");
+
+        FunctionData func_data;
+
+        loc.ForEachChildNamed("command", [&](const Element &elem)
+        {
+            // Construct the function.
+            Function this_func;
+
+            // Make sure the format is correct.
+            const auto &proto = elem.GetChild("proto");
+
+            // Get name.
+            this_func.name = proto.GetChild("name").GetContainedText();
+
+            // Get return type.
+            for (const auto &return_type_part : proto.elements)
+            {
+                if (!return_type_part.IsTagNamed("name") && !return_type_part.value.empty())
+                {
+                    if (this_func.return_type.size() > 0)
+                        this_func.return_type += ' ';
+                    this_func.return_type += return_type_part.GetContainedText();
+                }
+            }
+
+            // Get parameters.
+            elem.ForEachChildNamed("param", [&](const Element &elem)
+            {
+                // Construct the parameter.
+                this_func.params.push_back({});
+                auto &this_param = this_func.params.back();
+
+                // Get type.
+                bool seen_name = 0;
+                for (const auto &param_type_part : elem.elements)
+                {
+                    if (param_type_part.IsTagNamed("name"))
+                        seen_name = 1;
+
+                    if (!param_type_part.IsTagNamed("name") && !param_type_part.value.empty())
+                    {
+                        std::string &type = (seen_name ? this_param.type_r : this_param.type_l);
+
+                        if (type.size() > 0)
+                            type += ' ';
+                        type += param_type_part.GetContainedText();
+                    }
+                }
+
+                // Get name.
+                this_param.name = elem.GetChild("name").GetContainedText();
+
+                // Get category if this parameter has one.
+                if (elem.HasAttribute("group"))
+                    this_param.category = elem.GetAttribute("group");
+
+                // Get array size if this parameter has one.
+                if (elem.HasAttribute("len"))
+                    this_param.len = elem.GetAttribute("len");
+            });
+
+            // Insert function into the set.
+            if (!func_data.functions.insert(std::move(this_func)).second)
+                Error(Str("The spec contains more than one function named `", this_func.name, "`."));
+        });
+
+        return func_data;
+    }
+
+
+    // IDs of all function and enum names, including the ones that are only mentioned in versions and extensions.
+    struct SymbolData
+    {
+        SymbolTable functions, enums;
+    };
+
+    // The parts of the document used by `ExtractSymbols`, see `TreeBuilder`.
+    const std::vector<std::string_view> symbols_subtrees = {"registry/commands", "registry/enums", "registry/feature", "registry/extensions"};
+
+    SymbolData ExtractSymbols(const Element &root_element)
+    {
+        const Element &registry = root_element.GetChild("registry");
+
+        std::vector<std::string> functions, enums;
+
+        registry.GetChild("commands").ForEachChildNamed("command", [&](const Element &elem)
+        {
+            functions.emplace_back(elem.GetChild("proto").GetChild("name").GetContainedText());
+        });
+
+        registry.ForEachChildNamed("enums", [&](const Element &elem)
+        {
+            elem.ForEachChildNamed("enum", [&](const Element &elem)
+            {
+                enums.emplace_back(elem.GetAttribute("name"));
+            });
+        });
+
+        // Functions and enums mentioned in a `<require>` or `<remove>` of a version or an extension.
+        auto AddMentioned = [&](const Element &elem)
+        {
+            for (const char *block : {"require", "remove"})
+            {
+                elem.ForEachChildNamed(block, [&](const Element &elem)
+                {
+                    elem.ForEachChildNamed("command", [&](const Element &elem)
+                    {
+                        functions.emplace_back(elem.GetAttribute("name"));
+                    });
+                    elem.ForEachChildNamed("enum", [&](const Element &elem)
+                    {
+                        enums.emplace_back(elem.GetAttribute("name"));
+                    });
+                });
+            }
+        };
+        registry.ForEachChildNamed("feature", AddMentioned);
+        registry.GetChild("extensions").ForEachChildNamed("extension", AddMentioned);
+
+        return {std::move(functions), std::move(enums)};
+    }
+
+
+    struct Version
+    {
+        // This is set to the variant name, plus some optional suffix. Functions and enums are not inherited when it changes.
+        std::string sub_variant;
+
+        // The `*_deprecated` sets contain the symbols only available in the compatibility profile:
+        // the ones removed from the core profile, and the ones required only by the compatibility profile.
+        SymbolList functions, functions_deprecated; // IDs from `SymbolData::functions`.
+        SymbolList enums, enums_deprecated; // IDs from `SymbolData::enums`.
+    };
+
+    struct Variant
+    {
+        std::string name;
+        std::map<std::pair<int,int>, Version> versions;
+    };
+
+    struct VersionData
+    {
+        std::vector<Variant> variants;
+        int version_count;
+
+        void UpdateVersionCount()
+        {
+            version_count = 0;
+            for (const Variant &variant : variants)
+                version_count += variant.versions.size();
+        }
+
+        void PrettyPrint(std::ostream &stream, const SymbolData &symbols) const
+        {
+            stream << "variants {\n";
+
+            for (const auto &variant : variants)
+            {
+                stream << "    " << variant.name << " {\n";
+
+                for (const auto &version : variant.versions)
+                {
+                    stream << "        [ " << version.first.first << '.' << version.first.second << " , " << version.second.sub_variant << " ] {\n";
+
+                    stream << "            funcs_deprecated(" << version.second.functions_deprecated.size() << ") {";
+                    symbols.functions.PrintSet(stream, version.second.functions_deprecated);
+                    stream << " }\n";
+
+                    stream << "            enums_deprecated(" << version.second.enums_deprecated.size() << ") {";
+                    symbols.enums.PrintSet(stream, version.second.enums_deprecated);
+                    stream << " }\n";
+
+                    stream << "            funcs(" << version.second.functions.size() << ") {";
+                    symbols.functions.PrintSet(stream, version.second.functions);
+                    stream << " }\n";
+
+                    stream << "            enums(" << version.second.enums.size() << ") {";
+                    symbols.enums.PrintSet(stream, version.second.enums);
+                    stream << " }\n";
+
+                    stream << "        }\n";
+                }
+
+                stream << "    }\n";
+            }
+
+            stream << "}\n";
+        }
+    };
+
+    // The parts of the document used by `ExtractVersions`, see `TreeBuilder`.
+    const std::vector<std::string_view> versions_subtrees = {"registry/feature"};
+
+    VersionData ExtractVersions(const Element &root_element, const SymbolData &symbols)
+    {
+        VersionData version_data;
+
+        root_element.GetChild("registry").ForEachChildNamed("feature", [&](const Element &elem)
+        {
+            // Get version string.
+            std::string version_string(elem.GetAttribute("number"));
+
+            // Parse version string.
+            int version_major = 0, version_minor = 0;
+            {
+                bool major = 1;
+                for (const auto &ch : version_string)
+                {
+                    if (ch == '.' && major)
+                    {
+                        major = 0;
+                        continue;
+                    }
+
+                    if (ch < '0' || ch > '9')
+                        Error(Str("Unable to parse version string in `", elem.FullName(), "`."));
+
+                    auto &ver = major ? version_major : version_minor;
+                    ver = ver * 10 + (ch - '0');
+                }
+            }
+
+            // Get sub-variant name.
+            std::string sub_variant_name(elem.GetAttribute("api"));
+
+            // Get variant name by stripping numbers off the sub-variant name.
+            std::string variant_name = sub_variant_name;
+            while (variant_name.size() > 0 && variant_name.back() >= '0' && variant_name.back() <= '9')
+                variant_name.resize(variant_name.size()-1);
+
+            // Try finding an existing variant with this name.
+            auto variant_iter = std::find_if(version_data.variants.begin(), version_data.variants.end(), [&](const Variant &v){return v.name == variant_name;});
+
+            // If not found, construct it.
+            if (variant_iter == version_data.variants.end())
+            {
+                version_data.variants.push_back({});
+                variant_iter = version_data.variants.end()-1;
+                variant_iter->name = variant_name;
+            }
+
+            auto &this_variant = *variant_iter;
+
+            // Construct a new version.
+            auto [this_version_iter, this_version_is_unique] = this_variant.versions.insert({{version_major, version_minor}, {}});
+            if (!this_version_is_unique)
+                Error(Str("Duplicate internal version name `", this_variant.name, ":", version_major, ".", version_minor, "`. (A spec defect or an internal error.)."));
+
+            auto &this_version = this_version_iter->second;
+            this_version.sub_variant = sub_variant_name;
+
+            // Inherit from another this_version if necessary.
+            if (this_variant.versions.size() > 1)
+            {
+                auto parent_iter = std::prev(this_variant.versions.end(), 2); // We move 2 positions, because we have already inserted the new version at the end.
+                if (parent_iter->second.sub_variant == sub_variant_name)
+                    this_version = parent_iter->second;
+            }
+
+            // Get removed and added functions and enums.
+            // A `<remove>` for the core profile makes the symbols compatibility-only, other removals drop them from both profiles.
+            // A `<require>` for the compatibility profile only adds compatibility-only symbols, other requirements add them to both profiles.
+            // The blocks for other APIs are ignored.
+            std::vector<int> removed_functions, removed_enums, removed_core_functions, removed_core_enums;
+            std::vector<int> added_functions, added_enums, added_compat_functions, added_compat_enums;
+            auto AddSymbols = [&](const Element &elem, std::vector<int> &functions, std::vector<int> &enums)
+            {
+                if (elem.HasAttribute("api") && !elem.HasAttributeEqualTo("api", sub_variant_name))
+                    return;
+
+                elem.ForEachChildNamed("command", [&](const Element &elem)
+                {
+                    functions.push_back(symbols.functions.Get(elem.GetAttribute("name")));
+                });
+                elem.ForEachChildNamed("enum", [&](const Element &elem)
+                {
+                    enums.push_back(symbols.enums.Get(elem.GetAttribute("name")));
+                });
+            };
+            elem.ForEachChildNamed("remove", [&](const Element &elem)
+            {
+                if (elem.HasAttributeEqualTo("profile", "core"))
+                    AddSymbols(elem, removed_core_functions, removed_core_enums);
+                else
+                    AddSymbols(elem, removed_functions, removed_enums);
+            });
+            elem.ForEachChildNamed("require", [&](const Element &elem)
+            {
+                if (elem.HasAttributeEqualTo("profile", "compatibility"))
+                    AddSymbols(elem, added_compat_functions, added_compat_enums);
+                else
+                    AddSymbols(elem, added_functions, added_enums);
+            });
+
+            // The IDs are sorted once all blocks are read, rather than inserted one by one, since a feature can list thousands of symbols.
+            // The removals are applied first, so a symbol that's both removed and added stays.
+            auto Apply = [&](SymbolList &symbols, SymbolList &symbols_compat, std::vector<int> &removed_ids, std::vector<int> &removed_core_ids, std::vector<int> &added_ids, std::vector<int> &added_compat_ids)
+            {
+                SymbolList removed = SymbolList::FromUnsorted(std::move(removed_ids)), removed_core = SymbolList::FromUnsorted(std::move(removed_core_ids));
+                SymbolList added = SymbolList::FromUnsorted(std::move(added_ids)), added_compat = SymbolList::FromUnsorted(std::move(added_compat_ids));
+
+                symbols -= removed;
+                symbols_compat -= removed;
+
+                symbols_compat |= removed_core;
+                symbols -= removed_core;
+
+                symbols_compat -= added;
+                symbols |= added;
+
+                added_compat -= symbols;
+                symbols_compat |= added_compat;
+            };
+            Apply(this_version.functions, this_version.functions_deprecated, removed_functions, removed_core_functions, added_functions, added_compat_functions);
+            Apply(this_version.enums, this_version.enums_deprecated, removed_enums, removed_core_enums, added_enums, added_compat_enums);
+        });
+
+        version_data.UpdateVersionCount();
+
+        return version_data;
+    }
+
+
+    struct Extension
+    {
+        // The symbols required by the `<require>` blocks with the same `api` and `profile` attributes.
+        struct Requirement
+        {
+            std::string api, profile; // Empty if the symbols are required for all APIs or profiles.
+            SymbolList functions; // IDs from `SymbolData::functions`.
+            SymbolList enums; // IDs from `SymbolData::enums`.
+        };
+
+        std::vector<std::string> supported; // From the `supported` attribute: `gl`, `glcore` (the core profile), `gles2`, and so on.
+        std::vector<Requirement> requirements; // The ones without `api` and `profile` come first.
+
+        // `api` is the name from the `supported` attribute, see `Configuration::SupportedApiName()`.
+        bool IsSupported(std::string_view api) const
+        {
+            return std::find(supported.begin(), supported.end(), api) != supported.end();
+        }
+
+        // Adds the symbols required for `api` and `profile` to `functions` and `enums`.
+        // `api` is a feature API, e.g. `gl` or `gles2`. `profile` is `core`, `compatibility`, or empty if the version has no profiles (then all profiles are used).
+        void GetSymbols(std::string_view api, std::string_view profile, SymbolSet &functions, SymbolSet &enums) const
+        {
+            for (const Requirement &requirement : requirements)
+            {
+                if (requirement.api.size() > 0 && requirement.api != api)
+                    continue;
+                if (requirement.profile.size() > 0 && profile.size() > 0 && requirement.profile != profile)
+                    continue;
+                functions |= requirement.functions;
+                enums |= requirement.enums;
+            }
+        }
+    };
+
+    struct ExtensionData
+    {
+        std::map<std::string, Extension> extensions;
+
+        const Extension &Find(const std::string &name) const
+        {
+            auto it = extensions.find(name);
+            if (it == extensions.end())
+                Error(Str("Internal: Extension `", name, "` not found."));
+            return it->second;
+        }
+
+        void PrettyPrint(std::ostream &stream, const SymbolData &symbols) const
+        {
+            stream << "extensions {\n";
+
+            for (const auto &extension : extensions)
+            {
+                stream << "    " << extension.first << " {\n";
+
+                stream << "        supported {";
+                for (const std::string &api : extension.second.supported)
+                    stream << ' ' << api;
+                stream << " }\n";
+
+                for (const Extension::Requirement &requirement : extension.second.requirements)
+                {
+                    stream << "        require";
+                    if (requirement.api.size() > 0)
+                        stream << " api=" << requirement.api;
+                    if (requirement.profile.size() > 0)
+                        stream << " profile=" << requirement.profile;
+                    stream << " {\n";
+
+                    stream << "            funcs(" << requirement.functions.size() << ") {";
+                    symbols.functions.PrintSet(stream, requirement.functions);
+                    stream << " }\n";
+
+                    stream << "            enums(" << requirement.enums.size() << ") {";
+                    symbols.enums.PrintSet(stream, requirement.enums);
+                    stream << " }\n";
+
+                    stream << "        }\n";
+                }
+
+                stream << "    }\n";
+            }
+
+            stream << "}\n";
+        }
+    };
+
+    // The parts of the document used by `ExtractExtensions`, see `TreeBuilder`.
+    const std::vector<std::string_view> extensions_subtrees = {"registry/extensions"};
+
+    ExtensionData ExtractExtensions(const Element &root_element, const SymbolData &symbols)
+    {
+        ExtensionData extension_data;
+
+        root_element.GetChild("registry").GetChild("extensions").ForEachChildNamed("extension", [&](const Element &elem)
+        {
+            // Get name.
+            std::string name(elem.GetAttribute("name"));
+
+            // Construct the extension.
+            auto [this_extension_it, was_inserted] = extension_data.extensions.insert({name, {}});
+            if (!was_inserted)
+                Error(Str("The spec contains a duplicate extension: `", name, "`."));
+
+            auto &this_extension = this_extension_it->second;
+
+            // Get supported APIs.
+            std::string_view supported = elem.GetAttribute("supported");
+            while (supported.size() > 0)
+            {
+                std::size_t separator = supported.find('|');
+                this_extension.supported.emplace_back(supported.substr(0, separator));
+                supported.remove_prefix(separator == supported.npos ? supported.size() : separator + 1);
+            }
+
+            // Get functions and enums, grouping the blocks by API and profile.
+            this_extension.requirements.emplace_back();
+            elem.ForEachChildNamed("require", [&](const Element &elem)
+            {
+                std::string_view api = elem.HasAttribute("api") ? elem.GetAttribute("api") : "";
+                std::string_view profile = elem.HasAttribute("profile") ? elem.GetAttribute("profile") : "";
+
+                auto requirement = std::find_if(this_extension.requirements.begin(), this_extension.requirements.end(),
+                                                [&](const Extension::Requirement &r){return r.api == api && r.profile == profile;});
+                if (requirement == this_extension.requirements.end())
+                {
+                    requirement = this_extension.requirements.emplace(this_extension.requirements.end());
+                    requirement->api = api;
+                    requirement->profile = profile;
+                }
+
+                elem.ForEachChildNamed("command", [&](const Element &elem)
+                {
+                    requirement->functions.Insert(symbols.functions.Get(elem.GetAttribute("name")));
+                });
+
+                elem.ForEachChildNamed("enum", [&](const Element &elem)
+                {
+                    requirement->enums.Insert(symbols.enums.Get(elem.GetAttribute("name")));
+                });
+            });
+        });
+
+        return extension_data;
+    }
+
+    // Everything extracted from `gl.xml`.
+    struct Registry
+    {
+        TypeData types;
+        EnumData enum_data;
+        FunctionData func_data;
+        SymbolData symbol_data;
+        VersionData version_data;
+        ExtensionData extension_data;
+
+        // Indexed by symbol IDs. Null for the names that are mentioned in versions or extensions, but not defined.
+        // Moving the registry doesn't invalidate those, but copying would, so copying is disabled.
+        std::vector<const Function *> functions_by_id;
+        std::vector<const EnumConstant *> enums_by_id;
+
+        Registry() {}
+        Registry(Registry &&) = default;
+        Registry &operator=(Registry &&) = default;
+
+        // Updates `functions_by_id` and `enums_by_id` from the rest of the data.
+        void UpdateSymbolPointers()
+        {
+            functions_by_id.assign(symbol_data.functions.size(), nullptr);
+            for (std::size_t i = 0; i < functions_by_id.size(); i++)
+            {
+                if (auto it = func_data.functions.find(symbol_data.functions.Name(i)); it != func_data.functions.end())
+                    functions_by_id[i] = &*it;
+            }
+
+            enums_by_id.assign(symbol_data.enums.size(), nullptr);
+            for (std::size_t i = 0; i < enums_by_id.size(); i++)
+            {
+                if (auto it = enum_data.name_to_indices.find(symbol_data.enums.Name(i)); it != enum_data.name_to_indices.end())
+                    enums_by_id[i] = &enum_data.groups[it->second.first].elements[it->second.second];
+            }
+        }
+
+        const Function &GetFunction(int id) const
+        {
+            if (!functions_by_id[id])
+                Error(Str("Internal: Function `", symbol_data.functions.Name(id), "` not found."));
+            return *functions_by_id[id];
+        }
+
+        const EnumConstant &GetEnum(int id) const
+        {
+            if (!enums_by_id[id])
+                Error(Str("Internal: Enum constant `", symbol_data.enums.Name(id), "` not found."));
+            return *enums_by_id[id];
+        }
+    };
+
+    // A binary cache of the `Registry`, to skip parsing `gl.xml` when it doesn't change.
+    //
+    // The format is a header followed by a payload. The header contains the format version, the size and the hash of `gl.xml`,
+    // and the hash of the payload. The payload contains the registry, with all numbers stored in the native byte order,
+    // strings and containers prefixed with their 32-bit sizes.
+    // The file is memory-mapped when reading. Any mismatch or inconsistency causes the cache to be rebuilt.
+    namespace Cache
+    {
+        constexpr char magic[8] = {'C','G','L','F','L','R','E','G'};
+        constexpr std::uint32_t format_version = 6; // Increment this when changing the format or the `Registry` contents.
+        constexpr std::uint32_t byte_order_mark = 0x01020304;
+
+        const std::string default_file_name = "output/registry_cache.bin";
+
+        // FNV-1a.
+        std::uint64_t Hash(std::string_view data)
+        {
+            std::uint64_t ret = 0xcbf29ce484222325;
+            for (char ch : data)
+            {
+                ret ^= (unsigned char)ch;
+                ret *= 0x100000001b3;
+            }
+            return ret;
+        }
+
+        struct Header
+        {
+            char magic[8];
+            std::uint32_t format_version;
+            std::uint32_t byte_order_mark;
+            std::uint64_t source_size;
+            std::uint64_t source_hash;
+            std::uint64_t payload_size;
+            std::uint64_t payload_hash;
+        };
+
+        class Writer
+        {
+          public:
+            std::string data;
+
+            template <typename T> void Number(T value)
+            {
+                static_assert(std::is_arithmetic_v<T>);
+                data.append(reinterpret_cast<const char *>(&value), sizeof value);
+            }
+
+            void Size(std::size_t size)
+            {
+                if (size > UINT32_MAX)
+                    Error("Internal: The registry is too large to be cached.");
+                Number<std::uint32_t>(size);
+            }
+
+            void String(std::string_view str)
+            {
+                Size(str.size());
+                data += str;
+            }
+
+            template <typename C, typename F> void Container(const C &container, F &&func)
+            {
+                Size(container.size());
+                for (const auto &elem : container)
+                    func(elem);
+            }
+
+            void StringSet(const std::set<std::string> &set)
+            {
+                Container(set, [&](const std::string &str){String(str);});
+            }
+
+            void SymbolNames(const SymbolTable &table)
+            {
+                Container(table.Names(), [&](const std::string &str){String(str);});
+            }
+
+            void SymbolIds(const SymbolList &list)
+            {
+                Container(list.Ids(), [&](int id){Number<std::uint32_t>(id);});
+            }
+        };
+
+        class Reader
+        {
+            std::string_view data;
+
+          public:
+            // Thrown when reading past the end of data.
+            struct Corrupted {};
+
+            Reader(std::string_view data) : data(data) {}
+
+            bool AtEnd() const
+            {
+                return data.empty();
+            }
+
+            template <typename T> T Number()
+            {
+                static_assert(std::is_arithmetic_v<T>);
+                if (data.size() < sizeof(T))
+                    throw Corrupted{};
+                T ret;
+                std::memcpy(&ret, data.data(), sizeof ret);
+                data.remove_prefix(sizeof ret);
+                return ret;
+            }
+
+            // Each element of a container takes at least one byte, so a larger size means the data is corrupted.
+            std::size_t Size()
+            {
+                std::size_t ret = Number<std::uint32_t>();
+                if (ret > data.size())
+                    throw Corrupted{};
+                return ret;
+            }
+
+            std::string String()
+            {
+                std::size_t size = Size();
+                std::string ret(data.substr(0, size));
+                data.remove_prefix(size);
+                return ret;
+            }
+
+            template <typename F> void Container(F &&func)
+            {
+                std::size_t size = Size();
+                for (std::size_t i = 0; i < size; i++)
+                    func();
+            }
+
+            std::set<std::string> StringSet()
+            {
+                std::set<std::string> ret;
+                Container([&]{ret.insert(ret.end(), String());});
+                return ret;
+            }
+
+            SymbolTable SymbolNames()
+            {
+                std::vector<std::string> names;
+                Container([&]{names.push_back(String());});
+                if (!std::is_sorted(names.begin(), names.end()) || std::adjacent_find(names.begin(), names.end()) != names.end())
+                    throw Corrupted{};
+                return names;
+            }
+
+            // `id_count` is the size of the corresponding symbol table.
+            SymbolList SymbolIds(std::size_t id_count)
+            {
+                std::vector<int> ids;
+                Container([&]
+                {
+                    std::uint32_t id = Number<std::uint32_t>();
+                    if (id >= id_count || (ids.size() > 0 && int(id) <= ids.back()))
+                        throw Corrupted{};
+                    ids.push_back(id);
+                });
+                return ids;
+            }
+        };
+
+        void Save(Writer &writer, const Registry &registry)
+        {
+            writer.String(registry.types.code);
+            writer.Container(registry.types.names, [&](const std::string &name){writer.String(name);});
+
+            { // Enums
+                const EnumData &enum_data = registry.enum_data;
+                writer.Container(enum_data.groups, [&](const EnumGroup &group)
+                {
+                    writer.String(group.name);
+                    writer.Container(group.elements, [&](const EnumConstant &elem)
+                    {
+                        writer.String(elem.name);
+                        writer.String(elem.value);
+                        writer.String(elem.suffix);
+                        writer.Number(elem.value_number);
+                        writer.Number<std::uint8_t>(elem.negative);
+                    });
+                });
+                writer.Container(enum_data.categories, [&](const auto &category)
+                {
+                    writer.String(category.first);
+                    writer.StringSet(category.second);
+                });
+                writer.Number<std::int32_t>(enum_data.max_name_len);
+            }
+
+            // Functions
+            writer.Container(registry.func_data.functions, [&](const Function &func)
+            {
+                writer.String(func.name);
+                writer.String(func.return_type);
+                writer.Container(func.params, [&](const FunctionParam &param)
+                {
+                    writer.String(param.type_l);
+                    writer.String(param.type_r);
+                    writer.String(param.name);
+                    writer.String(param.category);
+                    writer.String(param.len);
+                });
+            });
+
+            // Symbols
+            writer.SymbolNames(registry.symbol_data.functions);
+            writer.SymbolNames(registry.symbol_data.enums);
+
+            // Versions
+            writer.Container(registry.version_data.variants, [&](const Variant &variant)
+            {
+                writer.String(variant.name);
+                writer.Container(variant.versions, [&](const auto &version)
+                {
+                    writer.Number<std::int32_t>(version.first.first);
+                    writer.Number<std::int32_t>(version.first.second);
+                    writer.String(version.second.sub_variant);
+                    writer.SymbolIds(version.second.functions);
+                    writer.SymbolIds(version.second.functions_deprecated);
+                    writer.SymbolIds(version.second.enums);
+                    writer.SymbolIds(version.second.enums_deprecated);
+                });
+            });
+
+            // Extensions
+            writer.Container(registry.extension_data.extensions, [&](const auto &extension)
+            {
+                writer.String(extension.first);
+                writer.Container(extension.second.supported, [&](const std::string &api){writer.String(api);});
+                writer.Container(extension.second.requirements, [&](const Extension::Requirement &requirement)
+                {
+                    writer.String(requirement.api);
+                    writer.String(requirement.profile);
+                    writer.SymbolIds(requirement.functions);
+                    writer.SymbolIds(requirement.enums);
+                });
+            });
+        }
+
+        void Load(Reader &reader, Registry &registry)
+        {
+            registry.types.code = reader.String();
+            reader.Container([&]{registry.types.names.push_back(reader.String());});
+
+            { // Enums
+                EnumData &enum_data = registry.enum_data;
+                reader.Container([&]
+                {
+                    EnumGroup &group = enum_data.groups.emplace_back();
+                    group.name = reader.String();
+                    reader.Container([&]
+                    {
+                        EnumConstant &elem = group.elements.emplace_back();
+                        elem.name = reader.String();
+                        elem.value = reader.String();
+                        elem.suffix = reader.String();
+                        elem.value_number = reader.Number<std::uint64_t>();
+                        elem.negative = reader.Number<std::uint8_t>();
+                    });
+                });
+                reader.Container([&]
+                {
+                    std::string name = reader.String();
+                    enum_data.categories.insert(enum_data.categories.end(), {std::move(name), reader.StringSet()});
+                });
+                enum_data.max_name_len = reader.Number<std::int32_t>();
+                enum_data.UpdateIndices();
+            }
+
+            // Functions
+            reader.Container([&]
+            {
+                Function func;
+                func.name = reader.String();
+                func.return_type = reader.String();
+                reader.Container([&]
+                {
+                    FunctionParam &param = func.params.emplace_back();
+                    param.type_l = reader.String();
+                    param.type_r = reader.String();
+                    param.name = reader.String();
+                    param.category = reader.String();
+                    param.len = reader.String();
+                });
+                registry.func_data.functions.insert(registry.func_data.functions.end(), std::move(func));
+            });
+
+            // Symbols
+            registry.symbol_data.functions = reader.SymbolNames();
+            registry.symbol_data.enums = reader.SymbolNames();
+            std::size_t function_count = registry.symbol_data.functions.size();
+            std::size_t enum_count = registry.symbol_data.enums.size();
+
+            // Versions
+            reader.Container([&]
+            {
+                Variant &variant = registry.version_data.variants.emplace_back();
+                variant.name = reader.String();
+                reader.Container([&]
+                {
+                    std::pair<int, int> number;
+                    number.first = reader.Number<std::int32_t>();
+                    number.second = reader.Number<std::int32_t>();
+                    Version &version = variant.versions[number];
+                    version.sub_variant = reader.String();
+                    version.functions = reader.SymbolIds(function_count);
+                    version.functions_deprecated = reader.SymbolIds(function_count);
+                    version.enums = reader.SymbolIds(enum_count);
+                    version.enums_deprecated = reader.SymbolIds(enum_count);
+                });
+            });
+            registry.version_data.UpdateVersionCount();
+
+            // Extensions
+            reader.Container([&]
+            {
+                std::string name = reader.String();
+                Extension &extension = registry.extension_data.extensions[name];
+                reader.Container([&]{extension.supported.push_back(reader.String());});
+                reader.Container([&]
+                {
+                    Extension::Requirement &requirement = extension.requirements.emplace_back();
+                    requirement.api = reader.String();
+                    requirement.profile = reader.String();
+                    requirement.functions = reader.SymbolIds(function_count);
+                    requirement.enums = reader.SymbolIds(enum_count);
+                });
+            });
+
+            registry.UpdateSymbolPointers();
+        }
+
+        // Returns nothing if the cache doesn't exist, is corrupted, or doesn't match the source.
+        std::optional<Registry> Read(const std::string &file_name, std::string_view source, std::uint64_t source_hash)
+        {
+            if (!std::filesystem::exists(file_name))
+                return {};
+
+            SourceFile file(file_name);
+            std::string_view data = file.View();
+
+            Header header;
+            if (data.size() < sizeof header)
+                return {};
+            std::memcpy(&header, data.data(), sizeof header);
+            data.remove_prefix(sizeof header);
+
+            if (std::memcmp(header.magic, magic, sizeof magic) != 0 || header.format_version != format_version || header.byte_order_mark != byte_order_mark)
+                return {};
+            if (header.source_size != source.size() || header.source_hash != source_hash)
+                return {};
+            if (header.payload_size != data.size() || header.payload_hash != Hash(data))
+                return {};
+
+            try
+            {
+                Registry ret;
+                Reader reader(data);
+                Load(reader, ret);
+                if (!reader.AtEnd())
+                    return {};
+                return ret;
+            }
+            catch (const Reader::Corrupted &)
+            {
+                return {};
+            }
+        }
+
+        // Returns false on failure.
+        bool Write(const std::string &file_name, const Registry &registry, std::string_view source, std::uint64_t source_hash)
+        {
+            Writer writer;
+            Save(writer, registry);
+
+            Header header{};
+            std::memcpy(header.magic, magic, sizeof magic);
+            header.format_version = format_version;
+            header.byte_order_mark = byte_order_mark;
+            header.source_size = source.size();
+            header.source_hash = source_hash;
+            header.payload_size = writer.data.size();
+            header.payload_hash = Hash(writer.data);
+
+            std::string data(reinterpret_cast<const char *>(&header), sizeof header);
+            data += writer.data;
+            return WriteFileAtomically(file_name, data);
+        }
+    }
+
+    // Pass this to `CodeWriter::Output()` to print `count` spaces, e.g. for alignment.
+    struct Spaces
+    {
+        std::size_t count = 0;
+    };
+
+    // Formats code into a string, maintaining the indentation.
+    // `{` and `}` change the indentation, a `@` at the beginning of a line makes it a label (indented by half a level), `$` is replaced with a space.
+    class CodeWriter
+    {
+        std::string &buffer;
+
+        bool at_line_start = 1;
+        int indentation = 0;
+        int section_depth = 0;
+
+        static constexpr const char *indentation_string = "    ", *indentation_string_labels = "  ";
+
+        // Characters that `OutputStr()` has to look at individually. Everything else is copied in bulk.
+        static constexpr std::string_view special_chars = "{}@$\n";
+
+        // Those convert `Output()` parameters to strings without going through iostreams.
+        void OutputParam(std::string_view str)
+        {
+            OutputStr(str);
+        }
+        void OutputParam(char ch)
+        {
+            OutputStr(std::string_view(&ch, 1));
+        }
+        void OutputParam(Spaces spaces)
+        {
+            if (at_line_start)
+                return; // Leading whitespace is discarded anyway.
+            buffer.append(spaces.count, ' ');
+        }
+        template <typename T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>, int> = 0>
+        void OutputParam(T number)
+        {
+            char number_buffer[24];
+            auto result = std::to_chars(number_buffer, number_buffer + sizeof number_buffer, number);
+            OutputStr(std::string_view(number_buffer, result.ptr - number_buffer));
+        }
+
+      public:
+        // Clears the `buffer`, then appends to it.
+        CodeWriter(std::string &buffer) : buffer(buffer)
+        {
+            buffer.clear();
+        }
+
+        void OutputStr(std::string_view str)
+        {
+            std::size_t pos = 0;
+            while (pos < str.size())
+            {
+                if (!at_line_start)
+                {
+                    std::size_t end = str.find_first_of(special_chars, pos);
+                    if (end == std::string_view::npos)
+                        end = str.size();
+                    buffer.append(str.data() + pos, end - pos);
+                    pos = end;
+                    if (pos == str.size())
+                        break;
+                }
+
+                char ch = str[pos++];
+
+                if (ch == '}' && indentation > 0)
+                    indentation--;
+
+                if (at_line_start)
+                {
+                    if (ch == ' ' || ch == '\t' || ch == '\r')
+                        continue;
+
+                    for (int i = 0; i < indentation; i++)
+                        buffer += (i == indentation-1 && ch == '@' ? indentation_string_labels : indentation_string);
+                    at_line_start = 0;
+                }
+
+                if (ch != '@')
+                    buffer += (ch == '$' ? ' ' : ch);
+
+                if (ch == '{')
+                    indentation++;
+
+                if (ch == '\n')
+                    at_line_start = 1;
+            }
+        }
+
+        template <typename ...P> void Output(const P &... params)
+        {
+            (OutputParam(params), ...);
+        }
+
+        template <typename F> void Section(std::string_view header, F &&func)
+        {
+            Output(header, "\n{\n");
+            func();
+            Output("}\n");
+        }
+        template <typename F> void SectionSemi(std::string_view header, F &&func) // 'sc' stands for 'end with semicolon'
+        {
+            Output(header, "\n{\n");
+            func();
+            Output("};\n");
+        }
+
+        template <typename F> void SectionDecorative(std::string_view name, F &&func)
+        {
+            Output("//{", Spaces{std::size_t(section_depth+1)}, name, "\n");
+            indentation--;
+            section_depth++;
+            func();
+            section_depth--;
+            Output("//}", Spaces{std::size_t(section_depth+1)}, name, "\n");
+            indentation++;
+        }
+
+        void NextLine()
+        {
+            Output("\n");
+        }
+    };
+
+    // Writes the file, unless an identical one already exists. Creates the directories as needed.
+    // Leaving the file untouched preserves its modification time, so the code including it doesn't get rebuilt needlessly.
+    void WriteFileIfChanged(const std::string &file_name, std::string_view contents, std::ostream &log)
+    {
+        std::error_code error;
+        if (std::filesystem::is_regular_file(file_name, error) && std::filesystem::file_size(file_name, error) == contents.size() && !error
+            && LoadFile(file_name) == contents)
+        {
+            log << "Generating `" << file_name << "` (unchanged)\n";
+            return;
+        }
+
+        log << "Generating `" << file_name << "`\n";
+
+        if (!WriteFileAtomically(file_name, contents))
+            Error(Str("Unable to write to `", file_name, "`."));
+    }
+
+    // Removes the generated files that a previous run left in the same `cglfl_generated` directories as `files`, but that aren't in `files`,
+    // e.g. `inline_api.hpp` after disabling `GenerateOptions::inline_api`. Only the files with `data::generated_file_marker` are removed,
+    // and then the subdirectories that became empty.
+    void RemoveStaleFiles(const std::vector<GeneratedFile> &files, std::ostream &log)
+    {
+        std::set<std::filesystem::path> dirs, current_files;
+        for (const GeneratedFile &file : files)
+        {
+            std::filesystem::path path = std::filesystem::path(file.name).lexically_normal();
+            current_files.insert(path);
+
+            std::filesystem::path dir;
+            for (const auto &part : path.parent_path())
+            {
+                dir /= part;
+                if (part == data::generated_dir_name)
+                {
+                    dirs.insert(dir);
+                    break;
+                }
+            }
+        }
+
+        for (const auto &dir : dirs)
+        {
+            std::error_code error;
+            std::vector<std::filesystem::path> stale_files, subdirs;
+            for (auto it = std::filesystem::recursive_directory_iterator(dir, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+            {
+                std::filesystem::path path = it->path().lexically_normal();
+                if (it->is_directory(error))
+                    subdirs.push_back(path);
+                if (!it->is_regular_file(error) || current_files.count(path))
+                    continue;
+
+                std::ifstream file(path, std::ios::binary);
+                std::string beginning(256, '\0');
+                file.read(beginning.data(), beginning.size());
+                beginning.resize(file.gcount());
+                if (beginning.find(data::generated_file_marker) != std::string::npos)
+                    stale_files.push_back(path);
+            }
+
+            for (const auto &path : stale_files)
+            {
+                log << "Removing stale `" << path.generic_string() << "`\n";
+                if (!std::filesystem::remove(path, error))
+                    Error(Str("Unable to remove `", path.generic_string(), "`."));
+            }
+
+            // Then the directories that became empty, such as `versions` and `extensions` after disabling `GenerateOptions::split_headers`.
+            // The nested ones come after their parents, so go backwards.
+            for (auto it = subdirs.rbegin(); it != subdirs.rend(); it++)
+            {
+                if (std::filesystem::is_empty(*it, error) && !error)
+                    std::filesystem::remove(*it, error);
+            }
+        }
+    }
+
+
+    // A selected API version and profile, and a set of extensions.
+    struct Configuration
+    {
+        std::string param_gl_version, param_gl_profile;
+
+        const Version *selected_version = 0;
+        const Variant *selected_version_variant = 0;
+        std::pair<int, int> selected_version_number;
+
+        bool core_profile = 0, compat_profile = 0; // At most one of those will be set.
+
+        std::vector<const Function *> primary_functions, all_functions;
+        std::vector<const EnumConstant *> all_enums;
+
+        std::map<std::string, std::vector<const Function *>> extensions; // Note that a single function can belong to several extensions, and maybe also to some versions.
+        std::map<std::string, std::vector<const EnumConstant *>> extension_enums; // Same, but for enums.
+
+        bool only_used_functions = 0; // If set, the functions that the application doesn't use were dropped from the lists above.
+        std::size_t unused_function_count = 0;
+
+        // The directory that the generated files go to.
+        std::string OutputDir() const
+        {
+            return Str("include/cglfl_",
+                       selected_version_variant->name, selected_version_number.first, ".", selected_version_number.second,
+                       core_profile ? "_core" : compat_profile ? "_compat" : "");
+        }
+
+        // The command line parameters that select this configuration.
+        std::string CommandLine() const
+        {
+            std::string ret = param_gl_version + (core_profile ? " core" : compat_profile ? " compat" : "");
+            for (const auto &[ext_name, ext] : extensions)
+                ret += " " + ext_name;
+            return ret;
+        }
+
+        // The API name used in the `supported` attribute of extensions, e.g. `gl`, `glcore` or `gles2`.
+        std::string SupportedApiName() const
+        {
+            return selected_version->sub_variant + (core_profile ? "core" : "");
+        }
+
+        // The profile name used in the `profile` attribute of `<require>` blocks. Empty if the version has no profiles.
+        std::string_view ProfileName() const
+        {
+            return core_profile ? "core" : compat_profile ? "compatibility" : "";
+        }
+    };
+
+    std::string VersionName(const Variant &variant, const std::pair<int, int> &version_number)
+    {
+        return Str(variant.name, version_number.first, ".", version_number.second);
+    }
+
+    // Whether a profile (core or compat) must be selected for this version.
+    bool NeedsProfile(const Version &version)
+    {
+        return version.enums_deprecated.size() > 0 || version.functions_deprecated.size() > 0;
+    }
+
+    // Adds the identifiers from `source` that look like function names, such as `glDrawArrays`, to `names`.
+    void FindFunctionNames(std::string_view source, std::set<std::string> &names)
+    {
+        auto IsNameChar = [](char ch) -> bool
+        {
+            return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || (ch >= '0' && ch <= '9') || ch == '_';
+        };
+
+        std::size_t pos = 0;
+        while (pos < source.size())
+        {
+            if (!IsNameChar(source[pos]))
+            {
+                pos++;
+                continue;
+            }
+
+            std::size_t end = pos;
+            while (end < source.size() && IsNameChar(source[end]))
+                end++;
+
+            std::string_view name = source.substr(pos, end - pos);
+            if (name.size() > 2 && name[0] == 'g' && name[1] == 'l' && name[2] >= 'A' && name[2] <= 'Z')
+                names.emplace(name);
+
+            pos = end;
+        }
+    }
+
+    // Reads a file with a name and a value on each line, skipping the empty lines and the lines starting with `#`.
+    // `func` receives the name and the value, and returns false if the value is invalid. `what` describes the expected line contents for the error messages.
+    template <typename F> void ForEachNameValueLine(const std::string &file_name, std::string_view what, F &&func)
+    {
+        std::istringstream file(LoadFile(file_name));
+        std::string line;
+        int line_number = 0;
+        while (std::getline(file, line))
+        {
+            line_number++;
+
+            std::istringstream line_stream(line);
+            std::string name, value, extra;
+            if (!(line_stream >> name) || name.front() == '#')
+                continue;
+
+            if (!(line_stream >> value) || line_stream >> extra || !func(std::move(name), value))
+                Error(Str("Expected ", what, " on line ", line_number, " of `", file_name, "`."));
+        }
+    }
+
+    // See `cglfl_generator::LoadCallCounts()`.
+    std::vector<std::pair<std::string, std::uint64_t>> LoadCallCounts(const std::string &file_name)
+    {
+        std::vector<std::pair<std::string, std::uint64_t>> ret;
+        ForEachNameValueLine(file_name, "a function name and a call count", [&](std::string name, const std::string &count)
+        {
+            std::uint64_t value = 0;
+            if (std::from_chars(count.data(), count.data() + count.size(), value).ptr != count.data() + count.size())
+                return false;
+            ret.emplace_back(std::move(name), value);
+            return true;
+        });
+        return ret;
+    }
+
+    // See `cglfl_generator::LoadSyncClasses()`.
+    std::vector<std::pair<std::string, std::string>> LoadSyncClasses(const std::string &file_name)
+    {
+        std::vector<std::pair<std::string, std::string>> ret;
+        ForEachNameValueLine(file_name, "a function name and a sync class", [&](std::string name, const std::string &sync_class)
+        {
+            if (!data::sync_class_names.count(sync_class))
+                return false;
+            ret.emplace_back(std::move(name), sync_class);
+            return true;
+        });
+        return ret;
+    }
+
+    // See `cglfl_generator::FindUsedFunctions()`.
+    std::vector<std::string> FindUsedFunctions(const UsageOptions &options)
+    {
+        std::set<std::string> names(options.keep.begin(), options.keep.end());
+
+        for (const std::string &path : options.sources)
+        {
+            std::error_code error;
+            if (!std::filesystem::is_directory(path, error))
+            {
+                FindFunctionNames(LoadFile(path), names);
+                continue;
+            }
+
+            std::filesystem::recursive_directory_iterator it(path, error), end;
+            if (error)
+                Error(Str("Unable to read directory `", path, "`."));
+            for (; it != end; it.increment(error))
+            {
+                if (error)
+                    Error(Str("Unable to read directory `", path, "`."));
+                if (it->is_regular_file(error) && data::source_file_extensions.count(it->path().extension().string()))
+                    FindFunctionNames(LoadFile(it->path().string()), names);
+            }
+        }
+
+        for (const std::string &file_name : options.symbol_files)
+        {
+            std::istringstream file(LoadFile(file_name));
+            std::string line;
+            while (std::getline(file, line))
+            {
+                std::istringstream line_stream(line);
+                std::string name;
+                if (line_stream >> name && name.front() != '#')
+                {
+                    do
+                        names.insert(name);
+                    while (line_stream >> name);
+                }
+            }
+        }
+
+        return {names.begin(), names.end()};
+    }
+
+    // Selects a configuration using `params`, which are the command line parameters: a version, a profile if needed, and extensions.
+    // If `used_functions` isn't null, drops the functions not listed in it, except the ones the runtime needs.
+    // The returned configuration points into the `registry`.
+    Configuration SelectConfiguration(const Registry &registry, std::vector<std::string> params, const std::vector<std::string> *used_functions)
+    {
+        const VersionData &version_data = registry.version_data;
+        const ExtensionData &extension_data = registry.extension_data;
+
+        Configuration config;
+
+        { // Find the version
+            if (params.empty())
+                Error("Not enough command line arguments, no version specified.");
+            config.param_gl_version = params.front();
+            params.erase(params.begin());
+
+            bool found = 0;
+            for (const Variant &variant : version_data.variants)
+            {
+                for (const auto &[number, version] : variant.versions)
+                {
+                    if (config.param_gl_version == VersionName(variant, number))
+                    {
+                        found = 1;
+                        config.selected_version = &version;
+                        config.selected_version_variant = &variant;
+                        config.selected_version_number = number;
+                        break;
+                    }
+                }
+
+                if (found)
+                    break;
+            }
+
+            if (!found)
+                Error("No such version: " + config.param_gl_version);
+        }
+
+        { // Find the profile (core or compat) if necessary
+            if (NeedsProfile(*config.selected_version))
+            {
+                if (params.empty())
+                    Error("Not enough command line arguments, no profile specified.");
+                config.param_gl_profile = params.front();
+                params.erase(params.begin());
+
+                config.core_profile = config.param_gl_profile == "core";
+                config.compat_profile = config.param_gl_profile == "compat";
+                if (!config.core_profile && !config.compat_profile)
+                    Error("No such profile: " + config.param_gl_profile);
+            }
+        }
+
+        SymbolSet selected_functions, selected_enums;
+
+        { // Make function and enum lists
+            // Function list
+            selected_functions |= config.selected_version->functions;
+            if (config.compat_profile)
+                selected_functions |= config.selected_version->functions_deprecated;
+
+            // Symbol IDs are sorted by name, so this list is sorted too.
+            selected_functions.ForEach([&](int id){config.primary_functions.push_back(&registry.GetFunction(id));});
+
+            // Enum list
+            selected_enums |= config.selected_version->enums;
+            if (config.compat_profile)
+                selected_enums |= config.selected_version->enums_deprecated;
+        }
+
+        std::set<std::string> selected_extensions;
+
+        { // Find the extensions
+            for (const std::string &param : params)
+            {
+                std::istringstream ss(param);
+                std::string ext_name;
+                while (ss >> ext_name)
+                {
+                    if (!extension_data.extensions.count(ext_name))
+                        Error("Extension not found: " + ext_name);
+                    if (!extension_data.Find(ext_name).IsSupported(config.SupportedApiName()))
+                        Error("Extension not supported by `" + config.SupportedApiName() + "`: " + ext_name);
+                    if (!selected_extensions.insert(ext_name).second)
+                        Error("Extension specified more than once: " + ext_name);
+                }
+            }
+        }
+
+        { // Make function and enum lists for extensions
+            for (const std::string &ext : selected_extensions)
+            {
+                const auto &ext_info = extension_data.Find(ext);
+                auto &funcs = config.extensions[ext];
+                auto &enums = config.extension_enums[ext];
+
+                // Only the blocks for this API and profile.
+                SymbolSet ext_functions, ext_enums;
+                ext_info.GetSymbols(config.selected_version->sub_variant, config.ProfileName(), ext_functions, ext_enums);
+
+                // Function list, sorted by name.
+                ext_functions.ForEach([&](int id){funcs.push_back(&registry.GetFunction(id));});
+                selected_functions |= ext_functions;
+
+                // Enum list
+                ext_enums.ForEach([&](int id){enums.push_back(&registry.GetEnum(id));});
+                selected_enums |= ext_enums;
+            }
+        }
+
+        if (used_functions)
+        { // Drop the unused functions
+            SymbolSet used;
+            for (const auto *list : {used_functions, &data::runtime_functions})
+            {
+                for (const std::string &name : *list)
+                {
+                    // Anything that isn't a function is ignored, since the sources are scanned for anything that looks like one.
+                    if (int id = registry.symbol_data.functions.Find(name); id != -1)
+                        used.Insert(id);
+                }
+            }
+
+            auto IsUnused = [&](const Function *func)
+            {
+                return !used.Contains(registry.symbol_data.functions.Get(func->name));
+            };
+
+            config.only_used_functions = 1;
+            config.unused_function_count = selected_functions.size();
+            selected_functions &= used;
+            config.unused_function_count -= selected_functions.size();
+
+            config.primary_functions.erase(std::remove_if(config.primary_functions.begin(), config.primary_functions.end(), IsUnused), config.primary_functions.end());
+            for (auto &[ext_name, funcs] : config.extensions)
+                funcs.erase(std::remove_if(funcs.begin(), funcs.end(), IsUnused), funcs.end());
+        }
+
+        { // Finalize function and enum lists
+            // Make combined function list, without duplicates.
+            selected_functions.ForEach([&](int id){config.all_functions.push_back(&registry.GetFunction(id));});
+
+            // Make enum list
+            selected_enums.ForEach([&](int id){config.all_enums.push_back(&registry.GetEnum(id));});
+        }
+
+        return config;
+    }
+
+    // The type of an `inline constexpr` enum constant, see `GenerateOptions::inline_api`.
+    std::string_view EnumConstantType(const EnumConstant &en)
+    {
+        if (en.suffix == "ull" || en.value_number > 0xffffffff)
+            return "GLuint64";
+        if (en.negative)
+            return "GLint";
+        return "GLenum";
+    }
+
+    // Returns the slot in `cglfl::context::functions` of each function in `config.all_functions`.
+    // Without call counts the slots follow the alphabetical order. Otherwise the most called functions come first, so the hot pointers share as few cache lines
+    // as possible. Then come the functions missing from the profile, in the alphabetical order, and finally the ones that were never called.
+    std::vector<int> AssignFunctionSlots(const Configuration &config, const GenerateOptions &options)
+    {
+        std::vector<int> order(config.all_functions.size());
+        std::iota(order.begin(), order.end(), 0);
+
+        if (options.call_counts.size() > 0)
+        {
+            std::map<std::string_view, std::uint64_t> counts;
+            for (const auto &[name, count] : options.call_counts)
+                counts[name] += count;
+
+            // Lower keys come first.
+            std::vector<std::pair<int, std::uint64_t>> keys;
+            keys.reserve(order.size());
+            for (const auto *func : config.all_functions)
+            {
+                auto it = counts.find(func->name);
+                if (it == counts.end())
+                    keys.emplace_back(1, 0);
+                else if (it->second == 0)
+                    keys.emplace_back(2, 0);
+                else
+                    keys.emplace_back(0, ~it->second);
+            }
+
+            std::stable_sort(order.begin(), order.end(), [&](int a, int b){return keys[a] < keys[b];});
+        }
+
+        std::vector<int> ret(order.size());
+        for (std::size_t slot = 0; slot < order.size(); slot++)
+            ret[order[slot]] = slot;
+        return ret;
+    }
+
+    // Returns the sync class of each function in `config.all_functions`, see `GenerateOptions::sync_classes`.
+    std::vector<std::string_view> AssignSyncClasses(const Configuration &config, const GenerateOptions &options)
+    {
+        for (const auto &[pattern, sync_class] : options.sync_classes)
+        {
+            if (!data::sync_class_names.count(sync_class))
+                Error(Str("Unknown sync class `", sync_class, "` for `", pattern, "`."));
+        }
+
+        auto Matches = [](std::string_view name, std::string_view pattern)
+        {
+            if (pattern.size() > 0 && pattern.back() == '*')
+                return name.substr(0, pattern.size() - 1) == pattern.substr(0, pattern.size() - 1);
+            return name == pattern;
+        };
+
+        std::vector<std::string_view> ret;
+        ret.reserve(config.all_functions.size());
+        for (const auto *func : config.all_functions)
+        {
+            std::string_view sync_class = "none";
+            bool found = 0;
+            for (const auto *patterns : {&options.sync_classes, &data::sync_class_patterns})
+            {
+                for (const auto &[pattern, pattern_class] : *patterns)
+                {
+                    if (Matches(func->name, pattern))
+                    {
+                        sync_class = pattern_class;
+                        found = 1;
+                        break;
+                    }
+                }
+                if (found)
+                    break;
+            }
+            ret.push_back(sync_class);
+        }
+        return ret;
+    }
+
+    // Generates the files for a configuration into `files`, reusing the existing elements. Nothing is written to the disk.
+    void GenerateConfiguration(const Registry &registry, const Configuration &config, std::vector<GeneratedFile> &files, const GenerateOptions &options)
+    {
+        const std::string &types = registry.types.code;
+
+        std::string disclaimer_generated =
+            "// This file is a part of CGLFL (configurable OpenGL function loader).\n" + data::generated_file_marker +
+            "//\n"
+            "// Version: " VERSION "\n"
+            "// API: " + Str(config.selected_version_variant->name, " ", config.selected_version_number.first, ".", config.selected_version_number.second,
+                config.core_profile ? " (core profile)" : config.compat_profile ? " (compatibility profile)" : "") + "\n"
+            "// Extensions:";
+
+        if (config.extensions.empty())
+        {
+            disclaimer_generated += " none";
+        }
+        else
+        {
+            for (const auto &[ext_name, ext] : config.extensions)
+                disclaimer_generated += " " + ext_name;
+        }
+
+        disclaimer_generated += "\n";
+
+        if (options.call_counts.size() > 0)
+            disclaimer_generated += "// Function slots: ordered by call counts\n";
+
+        if (config.only_used_functions)
+            disclaimer_generated += Str("// Functions: only the used ones, ", config.all_functions.size(), " of ", config.all_functions.size() + config.unused_function_count, "\n");
+
+        std::string data_dir = config.OutputDir() + "/" + data::generated_dir_name + "/";
+
+        // With `split_headers`, each function and enum is defined in exactly one of these headers, its home:
+        // the header of the oldest version that has it, or if the selected version doesn't have it, the header of the first extension that has it.
+        // The other extension headers include its home instead. Each version header includes the previous one.
+        // The slots don't depend on the split, so any headers can be included together.
+        struct SplitHeader
+        {
+            std::string name; // E.g. `versions/gl3.3.hpp` or `extensions/GL_KHR_debug.hpp`.
+            std::string comment;
+            std::vector<int> functions, enums; // Indices in `config.all_functions` and `config.all_enums`.
+            std::set<int> includes; // Indices of other headers.
+        };
+        std::vector<SplitHeader> split_headers;
+
+        if (options.split_headers)
+        {
+            Profile::Scope profile_scope("Split `" + data_dir + "`");
+
+            // The selected version, and the older ones it inherits from, oldest first.
+            std::vector<const Version *> versions;
+            for (const auto &[number, version] : config.selected_version_variant->versions)
+            {
+                if (number > config.selected_version_number)
+                    break;
+
+                if (version.sub_variant != config.selected_version->sub_variant)
+                {
+                    versions.clear();
+                    split_headers.clear();
+                    continue;
+                }
+
+                std::string version_name = VersionName(*config.selected_version_variant, number);
+                SplitHeader &header = split_headers.emplace_back();
+                header.name = "versions/" + version_name + ".hpp";
+                header.comment = "// The functions and enums added in " + version_name + ". The older ones come from the included header, if any.\n";
+                if (versions.size() > 0)
+                    header.includes.insert(versions.size() - 1);
+                versions.push_back(&version);
+            }
+
+            std::map<const Function *, int> function_homes;
+            std::map<const EnumConstant *, int> enum_homes;
+
+            // Returns the index of the oldest version that has the symbol, or -1 if the selected version doesn't have it.
+            auto FindVersion = [&](auto has_symbol) -> int
+            {
+                if (!has_symbol(*versions.back()))
+                    return -1;
+                int ret = 0;
+                while (!has_symbol(*versions[ret]))
+                    ret++;
+                return ret;
+            };
+
+            for (const Function *func : config.primary_functions)
+            {
+                int id = registry.symbol_data.functions.Get(func->name);
+                function_homes[func] = FindVersion([&](const Version &version)
+                {
+                    return version.functions.Contains(id) || (config.compat_profile && version.functions_deprecated.Contains(id));
+                });
+            }
+
+            for (const EnumConstant *en : config.all_enums)
+            {
+                int id = registry.symbol_data.enums.Get(en->name);
+                int home = FindVersion([&](const Version &version)
+                {
+                    return version.enums.Contains(id) || (config.compat_profile && version.enums_deprecated.Contains(id));
+                });
+                if (home != -1)
+                    enum_homes[en] = home;
+            }
+
+            for (const auto &[ext_name, ext] : config.extensions)
+            {
+                int index = split_headers.size();
+                SplitHeader &header = split_headers.emplace_back();
+                header.name = "extensions/" + ext_name + ".hpp";
+                header.comment = "// The functions and enums of " + ext_name + ". The ones that also belong to a version or to another extension come from the included headers.\n";
+
+                for (const Function *func : ext)
+                    function_homes.try_emplace(func, index);
+                for (const EnumConstant *en : config.extension_enums.at(ext_name))
+                    enum_homes.try_emplace(en, index);
+            }
+
+            for (std::size_t i = 0; i < config.all_functions.size(); i++)
+                split_headers[function_homes.at(config.all_functions[i])].functions.push_back(i);
+            for (std::size_t i = 0; i < config.all_enums.size(); i++)
+                split_headers[enum_homes.at(config.all_enums[i])].enums.push_back(i);
+
+            // Since the homes are the first headers that have the symbols, extension headers only include the preceding headers, so there are no cycles.
+            int index = versions.size();
+            for (const auto &[ext_name, ext] : config.extensions)
+            {
+                SplitHeader &header = split_headers[index];
+                for (const Function *func : ext)
+                    header.includes.insert(function_homes.at(func));
+                for (const EnumConstant *en : config.extension_enums.at(ext_name))
+                    header.includes.insert(enum_homes.at(en));
+                header.includes.erase(index);
+
+                // The newest of the version headers includes the rest of them.
+                if (auto it = header.includes.lower_bound(versions.size()); it != header.includes.begin())
+                    header.includes.erase(header.includes.begin(), std::prev(it));
+
+                index++;
+            }
+        }
+
+        // Indexed like `config.all_functions`.
+        std::vector<int> slots = AssignFunctionSlots(config, options);
+
+        files.resize((options.inline_api ? 7 : 4) + (options.split_headers ? split_headers.size() + 1 : 0));
+        std::size_t next_file = 4; // The first files are always the same.
+
+        std::vector<int> all_functions(config.all_functions.size()), all_enums(config.all_enums.size());
+        std::iota(all_functions.begin(), all_functions.end(), 0);
+        std::iota(all_enums.begin(), all_enums.end(), 0);
+
+        int max_func_name_len = 0;
+        for (const auto *func : config.all_functions)
+            if (int len = func->name.size(); len > max_func_name_len)
+                max_func_name_len = len;
+
+        int max_enum_name_len = 0;
+        for (const auto *en : config.all_enums)
+            if (int len = en->name.size(); len > max_enum_name_len)
+                max_enum_name_len = len;
+
+        // Defines the functions and the enums as macros. Goes to `macros_public.hpp`, or to `macros_shim.hpp` with `inline_api`, or to the split headers.
+        // `functions` and `enums` are indices in `config.all_functions` and `config.all_enums`.
+        auto OutputMacros = [&](CodeWriter &out, const std::vector<int> &functions, const std::vector<int> &enums)
+        {
+            // Functions
+            for (int index : functions)
+            {
+                const auto &func = *config.all_functions[index];
+                out.Output("#define ", func.name, Spaces{max_func_name_len - func.name.size()}, " CGLFL_CALL(",
+                    slots[index], ",",
+                    func.name, ",",
+                    func.MacroReturnType(), ",",
+                    func.params.size(), ","
+                    "(", func.ParameterList(Function::ParamMode::names_only), "),"
+                    "(", func.ParameterList(Function::ParamMode::full), "))\n");
+            }
+
+            if (functions.size() > 0 && enums.size() > 0)
+                out.NextLine();
+
+            // Enums
+            for (int index : enums)
+            {
+                const auto &en = *config.all_enums[index];
+                out.Output("#define ", en.name, Spaces{max_enum_name_len - en.name.size()}, " ", en.value, "\n");
+            }
+        };
+
+        // Same, but as inline functions and constants, for `inline_api`.
+        auto OutputInline = [&](CodeWriter &out, const std::vector<int> &functions, const std::vector<int> &enums)
+        {
+            // Functions
+            for (int index : functions)
+            {
+                const auto &func = *config.all_functions[index];
+                std::string param_names = func.ParameterList(Function::ParamMode::names_only);
+                std::string params = func.ParameterList(Function::ParamMode::full);
+                out.Output("inline ", func.return_type, func.NeedSpaceAfterReturnType() ? " " : "", func.name,
+                    "(", func.ParameterList(Function::ParamMode::full, 1), ") {return CGLFL_CALL(",
+                    slots[index], ",",
+                    func.name, ",",
+                    func.MacroReturnType(), ",",
+                    func.params.size(), ","
+                    "(", param_names, "),"
+                    "(", params, "))(", func.ParameterList(Function::ParamMode::names_only, 1), ");}\n");
+            }
+
+            // In the debug mode, the function-like macros pass the call sites to the debug hooks. Taking the addresses of the functions still works.
+            if (functions.size() > 0)
+            {
+                out.NextLine();
+                out.Output("#if defined(CGLFL_DEBUG) && !defined(CGLFL_MACRO_SHIM) && !defined(CGLFL_NO_DEBUG_CALL_SITES)\n");
+                for (int index : functions)
+                {
+                    const auto &func = *config.all_functions[index];
+                    out.Output("#define ", func.name, "(...)", Spaces{max_func_name_len - func.name.size()}, " CGLFL_DEBUG_WITH_CALL_SITE(", func.name, ", __VA_ARGS__)\n");
+                }
+                out.Output("#endif\n");
+            }
+
+            if (functions.size() > 0 && enums.size() > 0)
+                out.NextLine();
+
+            // Enums
+            for (int index : enums)
+            {
+                const auto &en = *config.all_enums[index];
+                out.Output("inline constexpr ", EnumConstantType(en), " ", en.name, Spaces{max_enum_name_len - en.name.size()}, " = ", en.value, ";\n");
+            }
+        };
+
+        // Replaces the definitions in `macros_public.hpp` or `inline_api.hpp` with `split_headers`.
+        auto OutputUmbrella = [&](CodeWriter &out)
+        {
+            out.Output("#ifndef CGLFL_NO_UMBRELLA_HEADER\n");
+            out.Output("#include <cglfl_generated/all.hpp>\n");
+            out.Output("#endif\n");
+        };
+
+        { // `types.hpp`
+            Profile::Scope profile_scope("Generate `" + data_dir + "types.hpp`");
+            GeneratedFile &file = files[0];
+            file.name = data_dir + "types.hpp";
+            CodeWriter out(file.contents);
+
+            out.Output("#pragma once\n\n");
+            out.Output(disclaimer_generated);
+
+            out.NextLine();
+
+            out.Output("#include <cstddef>\n");
+            out.Output("#include <cstdint>\n");
+
+            out.NextLine();
+
+            out.Output(&R"(
+                #ifndef CGLFL_API
+                #  if defined(__MINGW32__) || defined(__CYGWIN__) || (_MSC_VER >= 800) || defined(_STDCALL_SUPPORTED)
+                #    define CGLFL_API __stdcall
+                #  else
+                #    define CGLFL_API
+                #  endif
+                #endif
+            )"[1]);
+
+            out.NextLine();
+
+            out.Output(types);
+        }
+
+        { // `macros_internal.hpp`
+            Profile::Scope profile_scope("Generate `" + data_dir + "macros_internal.hpp`");
+            GeneratedFile &file = files[1];
+            file.name = data_dir + "macros_internal.hpp";
+            CodeWriter out(file.contents);
+
+            out.Output("#pragma once\n\n");
+            out.Output(disclaimer_generated);
+
+            out.NextLine();
+
+            // The loader tables. The function names are in the slot order, separated by `\0`, and `CGLFL_LOAD_NAME_OFFSETS` points to each of them.
+            // `CGLFL_LOAD_SLOTS` lists the slots to load: the primary functions, then the functions of each extension. Those lists begin at `CGLFL_LOAD_RANGES`,
+            // which has one element per list, and one for the end.
+            std::vector<int> functions_by_slot(config.all_functions.size());
+            std::map<const Function *, int> function_slots;
+            for (std::size_t index = 0; index < config.all_functions.size(); index++)
+            {
+                functions_by_slot[slots[index]] = index;
+                function_slots.try_emplace(config.all_functions[index], slots[index]);
+            }
+
+            std::vector<std::size_t> load_ranges = {0, config.primary_functions.size()};
+            for (const auto &[ext_name, ext] : config.extensions)
+                load_ranges.push_back(load_ranges.back() + ext.size());
+
+            out.Output("#define CGLFL_LOAD_NAMES");
+            for (int index : functions_by_slot)
+                out.Output(" \\\n$   \"", config.all_functions[index]->name, "\\0\"");
+            out.Output("\n");
+
+            out.Output("#define CGLFL_LOAD_NAME_OFFSETS");
+            std::size_t name_offset = 0;
+            for (std::size_t slot = 0; slot < functions_by_slot.size(); slot++)
+            {
+                out.Output(slot % 16 == 0 ? " \\\n$   " : " ", name_offset, ",");
+                name_offset += config.all_functions[functions_by_slot[slot]]->name.size() + 1;
+            }
+            out.Output("\n");
+
+            out.NextLine();
+
+            // The smallest index types that fit, usually 16-bit.
+            out.Output("#define CGLFL_LOAD_SLOT_TYPE std::uint", config.all_functions.size() <= 0xffff ? 16 : 32, "_t\n");
+            out.Output("#define CGLFL_LOAD_RANGE_TYPE std::uint", load_ranges.back() <= 0xffff ? 16 : 32, "_t\n");
+            out.Output("#define CGLFL_PRIMARY_FUNC_COUNT ", config.primary_functions.size(), "\n");
+            out.Output("#define CGLFL_LOAD_SLOT_COUNT ", load_ranges.back(), "\n");
+            out.Output("#define CGLFL_LOAD_SLOTS");
+            auto OutputLoadSlots = [&](std::string_view list_name, const std::vector<const Function *> &functions)
+            {
+                out.Output(" \\\n$   /* ", list_name, " */");
+                for (const auto *func : functions)
+                    out.Output(" \\\n$   ", function_slots.at(func), ", /* ", func->name, " */");
+            };
+            OutputLoadSlots("primary", config.primary_functions);
+            for (const auto &[ext_name, ext] : config.extensions)
+                OutputLoadSlots(ext_name, ext);
+            out.Output("\n");
+
+            out.Output("#define CGLFL_LOAD_RANGES");
+            for (std::size_t i = 0; i < load_ranges.size(); i++)
+                out.Output(i % 16 == 0 ? " \\\n$   " : " ", load_ranges[i], ",");
+            out.Output("\n");
+
+            out.NextLine();
+
+            out.Output("#define CGLFL_EXT_COUNT ", config.extensions.size(), "\n");
+            out.Output("#define CGLFL_EXTS(X)"); // This list should be sorted, to allow binary search.
+            if (config.extensions.empty())
+            {
+                out.Output(" // None");
+            }
+            else
+            {
+                for (const auto &[ext_name, ext] : config.extensions)
+                    out.Output(" \\\n$   X(", ext_name, ")");
+            }
+            out.Output("\n");
+
+            out.NextLine();
+
+            // The calls that can make the CPU wait for the GPU, see `cglfl::debug::sync_class`. Lists the slots, the names and the classes.
+            std::vector<std::string_view> sync_classes = AssignSyncClasses(config, options);
+            auto sync_point_count = std::count_if(sync_classes.begin(), sync_classes.end(), [](std::string_view c){return c != "none";});
+            out.Output("#define CGLFL_SYNC_POINT_COUNT ", sync_point_count, "\n");
+            out.Output("#define CGLFL_SYNC_POINTS(X)");
+            if (sync_point_count == 0)
+                out.Output(" // None");
+            for (std::size_t index = 0; index < config.all_functions.size(); index++)
+            {
+                if (sync_classes[index] != "none")
+                    out.Output(" \\\n$   X(", slots[index], ",", config.all_functions[index]->name, ",", sync_classes[index], ")");
+            }
+            out.Output("\n");
+
+        }
+
+        { // `macros_public.hpp`
+            Profile::Scope profile_scope("Generate `" + data_dir + "macros_public.hpp`");
+            GeneratedFile &file = files[2];
+            file.name = data_dir + "macros_public.hpp";
+            CodeWriter out(file.contents);
+
+            out.Output("#pragma once\n\n");
+            out.Output(disclaimer_generated);
+
+            out.NextLine();
+
+            // Some generic macros
+            out.Output("#define CGLFL_GL_MAJOR ", config.selected_version_number.first, "\n");
+            out.Output("#define CGLFL_GL_MINOR ", config.selected_version_number.second, "\n");
+            out.Output("#define CGLFL_GL_API_", config.selected_version_variant->name, "\n");
+            out.Output("#define CGLFL_GL_PROFILE_", config.core_profile ? "core" : config.compat_profile ? "compat" : "none", "\n");
+
+            out.NextLine();
+
+            // Metaprogramming helpers
+            out.Output("#define CGLFL_IMPL_FOR_EACH(m, n, ...) CGLFL_IMPL_CAT(CGLFL_IMPL_FOR_EACH_, n)(m, __VA_ARGS__)\n");
+            int max_func_params = 0;
+            for (const auto *func : config.all_functions)
+                if (max_func_params < int(func->params.size()))
+                    max_func_params = func->params.size();
+            for (int i = 0; i <= max_func_params; i++)
+            {
+                out.Output("#define CGLFL_IMPL_FOR_EACH_", i, "(m");
+                for (int j = 1; j <= i; j++)
+                    out.Output(", p", j);
+                if (i == 0)
+                    out.Output(", ...");
+                out.Output(")");
+                for (int j = 1; j <= i; j++)
+                    out.Output(" m(p", j, ")");
+                out.Output("\n");
+            }
+
+            out.NextLine();
+
+            // Function count
+            out.Output("#define CGLFL_FUNC_COUNT ", config.all_functions.size(), "\n");
+
+            out.NextLine();
+
+            if (options.split_headers)
+            {
+                // `src/cglfl.cpp` includes `all.hpp` when it sees this, even if the umbrella header is disabled.
+                out.Output("#define CGLFL_SPLIT_HEADERS\n");
+            }
+
+            if (options.inline_api)
+            {
+                // `cglfl.hpp` includes `inline_api.hpp` when it sees this.
+                out.Output("#define CGLFL_INLINE_API\n");
+            }
+            else if (options.split_headers)
+            {
+                out.NextLine();
+                OutputUmbrella(out);
+            }
+            else
+            {
+                OutputMacros(out, all_functions, all_enums);
+            }
+        }
+
+        { // `reflection.hpp`
+            Profile::Scope profile_scope("Generate `" + data_dir + "reflection.hpp`");
+            GeneratedFile &file = files[3];
+            file.name = data_dir + "reflection.hpp";
+            CodeWriter out(file.contents);
+
+            out.Output("#pragma once\n\n");
+            out.Output(disclaimer_generated);
+
+            out.NextLine();
+
+            out.Output("// The parameters of all functions, indexed by the function slots. Included by `cglfl/reflection.hpp`, which describes the format.\n");
+
+            out.NextLine();
+
+            std::vector<const Function *> functions_by_slot(config.all_functions.size());
+            for (std::size_t i = 0; i < config.all_functions.size(); i++)
+                functions_by_slot[slots[i]] = config.all_functions[i];
+
+            // Zero means none, so the IDs and the offsets start from 1.
+            std::map<std::string, int> group_ids, len_offsets;
+            std::size_t param_count = 0;
+            for (const Function *func : functions_by_slot)
+            {
+                for (const FunctionParam &param : func->params)
+                {
+                    if (param.category.size() > 0)
+                        group_ids[param.category];
+                    if (param.len.size() > 0)
+                        len_offsets[param.len];
+                }
+                param_count += func->params.size();
+            }
+
+            int next_group_id = 1;
+            for (auto &[name, id] : group_ids)
+                id = next_group_id++;
+
+            int next_len_offset = 1;
+            for (auto &[len, offset] : len_offsets)
+            {
+                offset = next_len_offset;
+                next_len_offset += len.size() + 1;
+            }
+
+            if (next_group_id > 0xffff || next_len_offset > 0xffff || param_count >= 1 << 24)
+                Error("Too many parameters for the reflection tables.");
+
+            // The reverse lookup tables for the enums, sorted by value. The first one has all constants, then one for each group, by group IDs.
+            // Only the constants that fit in `GLenum` are included. If several have the same value,
+            // the ones from the selected version are preferred over the extensions, then the shorter names.
+            std::vector<std::vector<const EnumConstant *>> enum_tables;
+            std::vector<std::string_view> enum_table_names;
+            std::map<std::string_view, int> enum_name_offsets;
+            {
+                std::map<std::string_view, const EnumConstant *> enums_by_name;
+                for (const EnumConstant *en : config.all_enums)
+                {
+                    if (!en->negative && en->value_number <= 0xffffffff)
+                        enums_by_name.emplace(en->name, en);
+                }
+
+                auto Rank = [&](const EnumConstant *en)
+                {
+                    int id = registry.symbol_data.enums.Get(en->name);
+                    bool in_version = config.selected_version->enums.Contains(id) || (config.compat_profile && config.selected_version->enums_deprecated.Contains(id));
+                    return std::make_tuple(!in_version, en->name.size(), std::string_view(en->name));
+                };
+
+                auto AddTable = [&](std::string_view table_name, auto &&names)
+                {
+                    enum_table_names.push_back(table_name);
+
+                    std::map<std::uint64_t, const EnumConstant *> by_value;
+                    for (std::string_view name : names)
+                    {
+                        auto it = enums_by_name.find(name);
+                        if (it == enums_by_name.end())
+                            continue;
+                        auto [value_it, inserted] = by_value.try_emplace(it->second->value_number, it->second);
+                        if (!inserted && Rank(it->second) < Rank(value_it->second))
+                            value_it->second = it->second;
+                    }
+
+                    auto &table = enum_tables.emplace_back();
+                    for (const auto &[value, en] : by_value)
+                    {
+                        table.push_back(en);
+                        enum_name_offsets[en->name];
+                    }
+                };
+
+                std::vector<std::string_view> all_names;
+                for (const auto &[name, en] : enums_by_name)
+                    all_names.push_back(name);
+                AddTable("All constants", all_names);
+
+                for (const auto &[group, id] : group_ids)
+                {
+                    auto it = registry.enum_data.categories.find(group);
+                    AddTable(group, it != registry.enum_data.categories.end() ? it->second : std::set<std::string>{});
+                }
+
+                std::size_t next_offset = 0;
+                for (auto &[name, offset] : enum_name_offsets)
+                {
+                    offset = next_offset;
+                    next_offset += name.size() + 1;
+                }
+            }
+
+            out.Section("namespace cglfl::reflection", [&]
+            {
+                out.SectionSemi("inline constexpr const char *group_names[] =", [&]
+                {
+                    out.Output("\"\",\n");
+                    for (const auto &[name, id] : group_ids)
+                        out.Output("\"", name, "\",\n");
+                });
+
+                out.Output("inline constexpr char len_strings[] =\n");
+                out.Output("$   \"\\0\"");
+                for (const auto &[len, offset] : len_offsets)
+                    out.Output("\n$   \"", len, "\\0\"");
+                out.Output(";\n");
+
+                // The last element is only there so that the array is never empty.
+                out.SectionSemi("inline constexpr param_info params[] =", [&]
+                {
+                    for (const Function *func : functions_by_slot)
+                    {
+                        if (func->params.empty())
+                            continue;
+                        for (const FunctionParam &param : func->params)
+                        {
+                            out.Output("{param_kind::", param.Kind(), ", ",
+                                param.category.size() > 0 ? group_ids.at(param.category) : 0, ", ",
+                                param.len.size() > 0 ? len_offsets.at(param.len) : 0, "}, ");
+                        }
+                        out.Output("// ", func->name, "\n");
+                    }
+                    out.Output("{},\n");
+                });
+
+                out.SectionSemi("inline constexpr function_info functions[CGLFL_FUNC_COUNT] =", [&]
+                {
+                    std::size_t first_param = 0;
+                    for (const Function *func : functions_by_slot)
+                    {
+                        out.Output("{", first_param, ", ", func->params.size(), "}, // ", func->name, "\n");
+                        first_param += func->params.size();
+                    }
+                });
+
+                out.Output("inline constexpr char enum_name_strings[] =");
+                for (const auto &[name, offset] : enum_name_offsets)
+                    out.Output("\n$   \"", name, "\\0\"");
+                if (enum_name_offsets.empty())
+                    out.Output(" \"\"");
+                out.Output(";\n");
+
+                // Same as with `params`, the last element is only there so that the array is never empty.
+                out.SectionSemi("inline constexpr enum_entry enum_entries[] =", [&]
+                {
+                    for (std::size_t i = 0; i < enum_tables.size(); i++)
+                    {
+                        out.Output("// ", enum_table_names[i], "\n");
+                        for (const EnumConstant *en : enum_tables[i])
+                        {
+                            char hex[16];
+                            auto result = std::to_chars(hex, hex + sizeof hex, en->value_number, 16);
+                            out.Output("{0x", std::string_view(hex, result.ptr - hex), ", ", enum_name_offsets.at(en->name), "},\n");
+                        }
+                    }
+                    out.Output("{},\n");
+                });
+
+                out.SectionSemi("inline constexpr std::uint32_t enum_group_ranges[] =", [&]
+                {
+                    std::size_t begin = 0;
+                    for (const auto &table : enum_tables)
+                    {
+                        out.Output(begin, ",\n");
+                        begin += table.size();
+                    }
+                    out.Output(begin, ",\n");
+                });
+            });
+        }
+
+        if (options.split_headers)
+        {
+            for (const SplitHeader &header : split_headers)
+            {
+                Profile::Scope profile_scope("Generate `" + data_dir + header.name + "`");
+                GeneratedFile &file = files[next_file++];
+                file.name = data_dir + header.name;
+                CodeWriter out(file.contents);
+
+                out.Output("#pragma once\n\n");
+                out.Output(disclaimer_generated);
+
+                out.NextLine();
+
+                out.Output(header.comment);
+
+                out.NextLine();
+
+                out.Output("#include <cglfl/cglfl.hpp>\n");
+                for (int index : header.includes)
+                    out.Output("#include <cglfl_generated/", split_headers[index].name, ">\n");
+
+                if (header.functions.size() > 0 || header.enums.size() > 0)
+                {
+                    out.NextLine();
+
+                    if (options.inline_api)
+                        OutputInline(out, header.functions, header.enums);
+                    else
+                        OutputMacros(out, header.functions, header.enums);
+                }
+            }
+
+            { // `all.hpp`
+                Profile::Scope profile_scope("Generate `" + data_dir + "all.hpp`");
+                GeneratedFile &file = files[next_file++];
+                file.name = data_dir + "all.hpp";
+                CodeWriter out(file.contents);
+
+                out.Output("#pragma once\n\n");
+                out.Output(disclaimer_generated);
+
+                out.NextLine();
+
+                out.Output("// The umbrella header, includes all split headers.\n"
+                           "// Included by `", options.inline_api ? "inline_api.hpp" : "macros_public.hpp", "`, unless `CGLFL_NO_UMBRELLA_HEADER` is defined.\n");
+
+                out.NextLine();
+
+                // The newest version header includes the older ones.
+                std::size_t version_count = split_headers.size() - config.extensions.size();
+                for (std::size_t i = version_count - 1; i < split_headers.size(); i++)
+                    out.Output("#include <cglfl_generated/", split_headers[i].name, ">\n");
+            }
+        }
+
+        if (!options.inline_api)
+            return;
+
+        { // `inline_api.hpp`
+            Profile::Scope profile_scope("Generate `" + data_dir + "inline_api.hpp`");
+            GeneratedFile &file = files[next_file++];
+            file.name = data_dir + "inline_api.hpp";
+            CodeWriter out(file.contents);
+
+            out.Output("#pragma once\n\n");
+            out.Output(disclaimer_generated);
+
+            out.NextLine();
+
+            out.Output("// The functions and the enums, as inline functions and constants rather than macros, so that this file can be precompiled.\n"
+                       "// Included at the end of `cglfl.hpp`.\n");
+
+            out.NextLine();
+
+            if (options.split_headers)
+                OutputUmbrella(out);
+            else
+                OutputInline(out, all_functions, all_enums);
+
+            out.NextLine();
+
+            out.Output("#ifdef CGLFL_MACRO_SHIM\n");
+            if (options.split_headers)
+            {
+                // The macros would break the split headers included after them.
+                out.Output("#ifdef CGLFL_NO_UMBRELLA_HEADER\n");
+                out.Output("#error \"`CGLFL_MACRO_SHIM` can't be used with `CGLFL_NO_UMBRELLA_HEADER`.\"\n");
+                out.Output("#endif\n");
+            }
+            out.Output("#include \"macros_shim.hpp\"\n");
+            out.Output("#endif\n");
+        }
+
+        { // `macros_shim.hpp`
+            Profile::Scope profile_scope("Generate `" + data_dir + "macros_shim.hpp`");
+            GeneratedFile &file = files[next_file++];
+            file.name = data_dir + "macros_shim.hpp";
+            CodeWriter out(file.contents);
+
+            out.Output("#pragma once\n\n");
+            out.Output(disclaimer_generated);
+
+            out.NextLine();
+
+            out.Output("// The functions and the enums as macros, for the code that relies on them being macros.\n"
+                       "// Included by `inline_api.hpp` if `CGLFL_MACRO_SHIM` is defined.\n");
+
+            out.NextLine();
+
+            OutputMacros(out, all_functions, all_enums);
+        }
+
+        { // `cglfl.cppm`
+            Profile::Scope profile_scope("Generate `" + data_dir + "cglfl.cppm`");
+            GeneratedFile &file = files[next_file++];
+            file.name = data_dir + "cglfl.cppm";
+            CodeWriter out(file.contents);
+
+            out.Output(disclaimer_generated);
+
+            out.NextLine();
+
+            out.Output("// A C++20 module that exports the whole API. Compile it as a module interface unit, and link `src/cglfl.cpp` as usual.\n"
+                       "// The macros from `cglfl/config.hpp` must be set when compiling the module, since they don't affect the importers.\n");
+
+            out.NextLine();
+
+            out.Output("module;\n\n#include <cglfl/cglfl.hpp>\n");
+            if (options.split_headers)
+                out.Output("#include <cglfl_generated/all.hpp>\n"); // In case the umbrella header is disabled.
+            out.Output("\nexport module cglfl;\n");
+
+            out.NextLine();
+
+            out.Section("export namespace cglfl", [&]
+            {
+                for (const char *name : data::module_exports)
+                    out.Output("using cglfl::", name, ";\n");
+
+                out.Section("namespace debug", [&]
+                {
+                    for (const char *name : data::module_exports_debug)
+                        out.Output("using cglfl::debug::", name, ";\n");
+                });
+            });
+
+            out.NextLine();
+
+            // Types
+            for (const std::string &name : registry.types.names)
+                out.Output("export using ::", name, ";\n");
+
+            out.NextLine();
+
+            // Functions
+            for (const auto *func : config.all_functions)
+                out.Output("export using ::", func->name, ";\n");
+
+            out.NextLine();
+
+            // Enums
+            for (const auto *en : config.all_enums)
+                out.Output("export using ::", en->name, ";\n");
+        }
+    }
+
+    // Parses `gl.xml` and extracts everything from it. Also dumps the intermediate data to `options.dump_dir`, if any.
+    Registry ParseRegistry(std::string_view source, const LoadOptions &options, std::ostream &log)
+    {
+        Document document;
+
+        if (options.streaming && options.lex_threads > 0)
+            Error("`--streaming` and `--parallel-lex` can't be used at the same time.");
+
+        if (options.streaming)
+        {
+            // Only keep the parts of the tree that the extractors need.
+            std::vector<std::string_view> subtrees;
+            for (const auto *list : {&types_subtrees, &enums_subtrees, &functions_subtrees, &symbols_subtrees, &versions_subtrees, &extensions_subtrees})
+                subtrees.insert(subtrees.end(), list->begin(), list->end());
+
+            log << "Lexing and parsing XML\n";
+            Profile::Scope profile_scope("Lex and parse");
+            document = ParseSource(source, subtrees);
+        }
+        else if (options.lex_threads > 0)
+        {
+            log << "Lexing XML (" << options.lex_threads << " threads)\n";
+            TokenList tokens;
+            {
+                Profile::Scope profile_scope("Lex");
+                ThreadPool pool(options.lex_threads);
+                tokens = LexSourceParallel(source, pool, options.lex_threads * 4);
+            }
+
+            log << "Parsing XML\n";
+            Profile::Scope profile_scope("Parse");
+            document = ParseTokens(std::move(tokens));
+        }
+        else
+        {
+            log << "Lexing XML\n";
+            TokenList tokens = [&]
+            {
+                Profile::Scope profile_scope("Lex");
+                return LexSource(source);
+            }();
+
+            log << "Parsing XML\n";
+            Profile::Scope profile_scope("Parse");
+            document = ParseTokens(std::move(tokens));
+        }
+
+        const Element &root_element = document.Root();
+
+        // With `--parallel-extract`, the dumps and the extraction stages run concurrently, since they only read the tree.
+        // Otherwise they are deferred, and run one by one when their results are requested.
+        // Either way, the progress is printed and the errors are reported in the same order.
+        std::optional<ThreadPool> pool;
+        if (options.extract_threads > 0)
+            pool.emplace(options.extract_threads);
+
+        auto Launch = [&](auto func)
+        {
+            return pool ? pool->Run(func) : std::async(std::launch::deferred, func);
+        };
+        auto WaitForAll = [&](auto &... futures)
+        {
+            // Even if one of the tasks fails, we must wait for the rest, since they reference local variables.
+            if (pool)
+                (futures.wait(), ...);
+        };
+        // Wraps `func` to record it as a stage for `--profile`.
+        auto Profiled = [](const char *name, auto func)
+        {
+            return [name, func]
+            {
+                Profile::Scope profile_scope(name);
+                return func();
+            };
+        };
+        // Does nothing if `options.dump_dir` is empty.
+        auto DumpToFile = [&](std::string_view name, auto func)
+        {
+            std::string file_name = options.dump_dir.empty() ? "" : options.dump_dir + "/" + std::string(name);
+            return Launch([file_name, func]
+            {
+                if (file_name.empty())
+                    return;
+                Profile::Scope profile_scope("Dump `" + file_name + "`");
+                std::ofstream file(file_name);
+                if (!file) Error(Str("Unable to open `", file_name, "` for writing."));
+                func(file);
+            });
+        };
+
+        #if 1
+        if (!options.dump_dir.empty())
+            std::filesystem::create_directories(options.dump_dir);
+        auto xml_tree_dump = DumpToFile("xml_tree_dump.txt", [&](std::ostream &file){root_element.PrettyPrint(file);});
+        #else
+        auto xml_tree_dump = Launch([]{});
+        #endif
+
+        auto types_future          = Launch(Profiled("Extract types",      [&]{return ExtractTypes(root_element);}));
+        auto enum_data_future      = Launch(Profiled("Extract enums",      [&]{return ExtractEnums(root_element);}));
+        auto func_data_future      = Launch(Profiled("Extract functions",  [&]{return ExtractFunctions(root_element);}));
+        auto symbol_data_future    = Launch(Profiled("Extract symbols",    [&]{return ExtractSymbols(root_element);})).share();
+        // Those wait for the symbols. It can't deadlock, since the pool starts the tasks in order.
+        auto version_data_future   = Launch(Profiled("Extract versions",   [&]{return ExtractVersions(root_element, symbol_data_future.get());}));
+        auto extension_data_future = Launch(Profiled("Extract extensions", [&]{return ExtractExtensions(root_element, symbol_data_future.get());}));
+        WaitForAll(xml_tree_dump, types_future, enum_data_future, func_data_future, symbol_data_future, version_data_future, extension_data_future);
+
+        #if 1
+        log << "Dumping XML tree\n";
+        #endif
+        xml_tree_dump.get();
+
+        Registry registry;
+
+        log << "Extracting types\n";
+        registry.types = types_future.get();
+
+        log << "Extracting enum constants";
+        registry.enum_data = enum_data_future.get();
+        log << " - " << registry.enum_data.enum_count << " found\n";
+
+        log << "Extracting functions     ";
+        registry.func_data = func_data_future.get();
+        log << " - " << registry.func_data.functions.size() << " found\n";
+
+        log << "Extracting symbols       ";
+        registry.symbol_data = symbol_data_future.get();
+        log << " - " << registry.symbol_data.functions.size() << " functions, " << registry.symbol_data.enums.size() << " enums\n";
+        registry.UpdateSymbolPointers();
+
+        log << "Extracting versions      ";
+        registry.version_data = version_data_future.get();
+        log << " - " << registry.version_data.version_count << " found\n";
+
+        log << "Extracting extensions    ";
+        registry.extension_data = extension_data_future.get();
+        log << " - " << registry.extension_data.extensions.size() << " found\n";
+
+        log << "Dumping data\n";
+        #if 1
+        { // Dump more data
+            if (!options.dump_dir.empty())
+            std::filesystem::create_directories(options.dump_dir);
+
+            auto types_dump      = DumpToFile("types_dump.txt"     , [&](std::ostream &file){file << registry.types.code;});
+            auto enums_dump      = DumpToFile("enums_dump.txt"     , [&](std::ostream &file){registry.enum_data.PrettyPrint(file);});
+            auto functions_dump  = DumpToFile("functions_dump.txt" , [&](std::ostream &file){registry.func_data.PrettyPrint(file);});
+            auto versions_dump   = DumpToFile("versions_dump.txt"  , [&](std::ostream &file){registry.version_data.PrettyPrint(file, registry.symbol_data);});
+            auto extensions_dump = DumpToFile("extensions_dump.txt", [&](std::ostream &file){registry.extension_data.PrettyPrint(file, registry.symbol_data);});
+            WaitForAll(types_dump, enums_dump, functions_dump, versions_dump, extensions_dump);
+
+            types_dump.get();
+            enums_dump.get();
+            functions_dump.get();
+            versions_dump.get();
+            extensions_dump.get();
+        }
+        #endif
+
+
+        return registry;
+    }
+
+    // Loads the registry from the cache if possible. Otherwise parses it, and updates the cache.
+    Registry LoadRegistry(const LoadOptions &options, std::ostream &log)
+    {
+        log << "Loading `" << options.xml_file << "`\n";
+        std::optional<SourceFile> source_file;
+        {
+            Profile::Scope profile_scope("Load `" + options.xml_file + "`");
+            source_file.emplace(options.xml_file, options.use_mmap);
+        }
+        std::string_view source = source_file->View();
+
+        std::uint64_t source_hash = 0;
+        if (options.cache_file.size() > 0)
+        {
+            std::optional<Registry> cached_registry;
+            {
+                Profile::Scope profile_scope("Read cache");
+                source_hash = Cache::Hash(source);
+                cached_registry = Cache::Read(options.cache_file, source, source_hash);
+            }
+
+            if (cached_registry)
+            {
+                log << "Loaded the registry from `" << options.cache_file << "`\n";
+                return std::move(*cached_registry);
+            }
+        }
+
+        Registry registry = ParseRegistry(source, options, log);
+
+        if (options.cache_file.size() > 0)
+        {
+            log << "Writing `" << options.cache_file << "`\n";
+            Profile::Scope profile_scope("Write cache");
+            if (!Cache::Write(options.cache_file, registry, source, source_hash))
+                log << "Warning: Unable to write the registry cache.\n";
+        }
+
+        return registry;
+    }
+
+    // Makes sure all supported scanning kernels produce the same tokens as the scalar ones.
+    // Also compares the parallel lexer with the sequential one.
+    bool CheckScanKernels(const LoadOptions &options, std::ostream &log)
+    {
+        log << "Loading `" << options.xml_file << "`\n";
+        SourceFile source(options.xml_file, options.use_mmap);
+
+        bool ok = 1;
+        TokenList expected;
+        for (const Scan::Kernels &kernels : Scan::AllKernels())
+        {
+            if (!kernels.is_supported())
+            {
+                log << "Kernels `" << kernels.name << "`: not supported\n";
+                continue;
+            }
+
+            auto time_start = std::chrono::steady_clock::now();
+            TokenList tokens = LexSource(source.View(), kernels);
+            auto time_end = std::chrono::steady_clock::now();
+
+            bool same = 1;
+            if (&kernels == &Scan::AllKernels().front())
+                expected = std::move(tokens);
+            else
+                same = tokens.tokens == expected.tokens;
+            ok = ok && same;
+
+            log << "Kernels `" << kernels.name << "`: " << (same ? "ok" : "MISMATCH") << ", "
+                << std::chrono::duration<double, std::milli>(time_end - time_start).count() << " ms\n";
+        }
+
+        { // Parallel lexer
+            ThreadPool pool(options.lex_threads > 0 ? options.lex_threads : ThreadPool::DefaultThreadCount());
+            bool same = LexSourceParallel(source.View(), pool, 64).tokens == expected.tokens;
+            ok = ok && same;
+            log << "Parallel lexing: " << (same ? "ok" : "MISMATCH") << "\n";
+        }
+
+        return ok;
+    }
+}
+
+namespace cglfl_generator
+{
+    namespace impl
+    {
+        // Discards everything, used when no log is specified.
+        std::ostream &NullLog()
+        {
+            thread_local std::ostream ret(nullptr);
+            return ret;
+        }
+
+        // A configuration, plus the registry it points into.
+        struct ConfigurationHolder
+        {
+            std::shared_ptr<const Registry> registry;
+            Configuration config;
+        };
+    }
+
+    const char *Version()
+    {
+        return VERSION;
+    }
+
+    int DefaultThreadCount()
+    {
+        return impl::ThreadPool::DefaultThreadCount();
+    }
+
+    std::string VersionInfo::Name() const
+    {
+        return impl::Str(api, major, ".", minor);
+    }
+
+
+    Configuration::Configuration() {}
+
+    std::string Configuration::OutputDir() const
+    {
+        if (!data)
+            impl::Error("The configuration is empty.");
+        return data->OutputDir();
+    }
+
+    std::string Configuration::CommandLine() const
+    {
+        if (!data)
+            impl::Error("The configuration is empty.");
+        return data->CommandLine();
+    }
+
+
+    Registry::Registry() {}
+
+    Registry Registry::Load(const LoadOptions &options)
+    {
+        Registry ret;
+        ret.data = std::make_shared<const impl::Registry>(impl::LoadRegistry(options, options.log ? *options.log : impl::NullLog()));
+        return ret;
+    }
+
+    std::vector<VersionInfo> Registry::Versions() const
+    {
+        if (!data)
+            impl::Error("The registry is empty.");
+
+        std::vector<VersionInfo> ret;
+        for (const impl::Variant &variant : data->version_data.variants)
+        {
+            for (const auto &[number, version] : variant.versions)
+            {
+                VersionInfo &info = ret.emplace_back();
+                info.api = variant.name;
+                info.major = number.first;
+                info.minor = number.second;
+                info.has_profiles = impl::NeedsProfile(version);
+            }
+        }
+        return ret;
+    }
+
+    std::vector<std::string> Registry::Extensions() const
+    {
+        if (!data)
+            impl::Error("The registry is empty.");
+
+        std::vector<std::string> ret;
+        for (const auto &[name, ext] : data->extension_data.extensions)
+            ret.push_back(name);
+        return ret;
+    }
+
+    std::vector<std::string> Registry::Extensions(const Configuration &config) const
+    {
+        if (!data)
+            impl::Error("The registry is empty.");
+        if (!config.data)
+            impl::Error("The configuration is empty.");
+
+        std::string api = config.data->SupportedApiName();
+        std::vector<std::string> ret;
+        for (const auto &[name, ext] : data->extension_data.extensions)
+        {
+            if (ext.IsSupported(api))
+                ret.push_back(name);
+        }
+        return ret;
+    }
+
+    std::vector<std::string> FindUsedFunctions(const UsageOptions &options)
+    {
+        impl::Profile::Scope profile_scope("Find used functions");
+        return impl::FindUsedFunctions(options);
+    }
+
+    std::vector<std::pair<std::string, std::uint64_t>> LoadCallCounts(const std::string &file_name)
+    {
+        return impl::LoadCallCounts(file_name);
+    }
+
+    std::vector<std::pair<std::string, std::string>> LoadSyncClasses(const std::string &file_name)
+    {
+        return impl::LoadSyncClasses(file_name);
+    }
+
+    Configuration Registry::Select(const std::vector<std::string> &params, const std::vector<std::string> *used_functions) const
+    {
+        if (!data)
+            impl::Error("The registry is empty.");
+
+        auto holder = std::make_shared<impl::ConfigurationHolder>();
+        holder->registry = data;
+        {
+            impl::Profile::Scope profile_scope("Select configuration");
+            holder->config = impl::SelectConfiguration(*data, params, used_functions);
+        }
+
+        Configuration ret;
+        ret.data = std::shared_ptr<const impl::Configuration>(holder, &holder->config);
+        return ret;
+    }
+
+    void Registry::Generate(const Configuration &config, std::vector<GeneratedFile> &files, const GenerateOptions &options) const
+    {
+        if (!data)
+            impl::Error("The registry is empty.");
+        if (!config.data)
+            impl::Error("The configuration is empty.");
+        impl::GenerateConfiguration(*data, *config.data, files, options);
+    }
+
+
+    void WriteFiles(const std::vector<GeneratedFile> &files, std::ostream *log)
+    {
+        for (const GeneratedFile &file : files)
+            impl::WriteFileIfChanged(file.name, file.contents, log ? *log : impl::NullLog());
+        impl::RemoveStaleFiles(files, log ? *log : impl::NullLog());
+    }
+
+    bool GenerateBatch(const Registry &registry, std::vector<BatchEntry> &entries, int thread_count, const GenerateOptions &options)
+    {
+        std::vector<Configuration> configs(entries.size());
+        for (BatchEntry &entry : entries)
+        {
+            entry.log.clear();
+            entry.error.clear();
+        }
+
+        impl::ThreadPool pool(thread_count);
+
+        // Runs `func(i)` for each entry that didn't fail yet, in parallel. Catches the errors.
+        auto ForEachEntry = [&](auto func)
+        {
+            std::vector<std::future<void>> tasks;
+            for (std::size_t i = 0; i < entries.size(); i++)
+            {
+                if (entries[i].error.size() > 0)
+                    continue;
+                tasks.push_back(pool.Run([&entries, &func, i]
+                {
+                    try
+                    {
+                        func(i);
+                    }
+                    catch (const GeneratorError &e)
+                    {
+                        entries[i].error = e.what();
+                    }
+                }));
+            }
+            // Even if one of the tasks throws something else, we must wait for the rest, since they reference `func`.
+            for (auto &task : tasks)
+                task.wait();
+            for (auto &task : tasks)
+                task.get();
+        };
+
+        // Select the functions and enums.
+        ForEachEntry([&](std::size_t i)
+        {
+            auto holder = std::make_shared<impl::ConfigurationHolder>();
+            holder->registry = registry.data;
+            {
+                impl::Profile::Scope profile_scope("Select configuration (" + entries[i].description + ")");
+                holder->config = impl::SelectConfiguration(*registry.data, entries[i].params, entries[i].used_functions);
+            }
+            configs[i].data = std::shared_ptr<const impl::Configuration>(holder, &holder->config);
+        });
+
+        // Make sure no two configurations write to the same directory.
+        std::map<std::string, const BatchEntry *> output_dirs;
+        for (std::size_t i = 0; i < entries.size(); i++)
+        {
+            if (entries[i].error.size() > 0)
+                continue;
+            auto [it, inserted] = output_dirs.insert({configs[i].OutputDir(), &entries[i]});
+            if (!inserted)
+                entries[i].error = impl::Str("Same output directory as the configuration on ", it->second->description, ": `", it->first, "`.");
+        }
+
+        // Generate and write the files.
+        ForEachEntry([&](std::size_t i)
+        {
+            std::ostringstream log;
+            try
+            {
+                std::vector<GeneratedFile> files;
+                registry.Generate(configs[i], files, options);
+                WriteFiles(files, &log);
+            }
+            catch (...)
+            {
+                entries[i].log = log.str();
+                throw;
+            }
+            entries[i].log = log.str();
+        });
+
+        return std::none_of(entries.begin(), entries.end(), [](const BatchEntry &entry){return entry.error.size() > 0;});
+    }
+
+
+    bool SetScanKernels(std::string_view name)
+    {
+        const impl::Scan::Kernels *kernels = impl::Scan::FindKernels(name);
+        if (!kernels)
+            return 0;
+        impl::Scan::current = kernels;
+        return 1;
+    }
+
+    bool CheckScanKernels(const LoadOptions &options, std::ostream &log)
+    {
+        return impl::CheckScanKernels(options, log);
+    }
+
+
+    namespace profile
+    {
+        void Enable(std::uint64_t (*allocation_count)())
+        {
+            impl::Profile::Enable(allocation_count);
+        }
+
+        bool IsEnabled()
+        {
+            return impl::Profile::IsEnabled();
+        }
+
+        std::vector<Stage> Stages()
+        {
+            std::vector<Stage> ret;
+            for (const impl::Profile::Stage &stage : impl::Profile::Stages())
+                ret.push_back({stage.name, stage.finished, stage.wall_ms, stage.cpu_ms, stage.allocations, stage.peak_rss_kib});
+            return ret;
+        }
+
+        void Clear()
+        {
+            impl::Profile::Clear();
+        }
+
+        void Report(std::ostream &out, const std::string &json_file_name)
+        {
+            impl::Profile::Report(out, json_file_name);
+        }
+    }
+}
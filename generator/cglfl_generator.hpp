@@ -0,0 +1,217 @@
+#pragma once
+
+// The CGLFL code generator, as a library.
+// Load a `Registry` once, then select and generate any number of configurations from it, possibly from several threads.
+// All errors are reported by throwing `GeneratorError`.
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace cglfl_generator
+{
+    namespace impl
+    {
+        struct Registry;
+        struct Configuration;
+    }
+
+    // The message is suitable for showing to the user.
+    struct GeneratorError : std::runtime_error
+    {
+        using std::runtime_error::runtime_error;
+    };
+
+    // The generator version, written to the generated files.
+    const char *Version();
+
+    // The number of threads used by default for the parallel modes.
+    int DefaultThreadCount();
+
+    struct LoadOptions
+    {
+        std::string xml_file = "gl.xml";
+        std::string cache_file = "output/registry_cache.bin"; // A binary cache of the parsed registry. If empty, the cache isn't used.
+        std::string dump_dir = "output"; // The intermediate data is dumped here, for debugging. If empty, nothing is dumped.
+        std::ostream *log = nullptr; // Progress messages go here. If null, they are discarded.
+
+        bool use_mmap = 1;
+        bool streaming = 0; // Lex and parse in one pass, dropping the unused parts of the document. Can't be used with `lex_threads`.
+        int lex_threads = 0; // If not zero, lex in parallel with this many threads.
+        int extract_threads = 0; // If not zero, run the extraction stages and dumps in parallel with this many threads.
+    };
+
+    struct VersionInfo
+    {
+        std::string api; // `gl`, `gles`, and so on.
+        int major = 0, minor = 0;
+        bool has_profiles = 0; // If true, selecting this version requires a profile, `core` or `compat`.
+
+        std::string Name() const; // E.g. `gl4.6`.
+    };
+
+    // How the generated headers expose the API.
+    struct GenerateOptions
+    {
+        // If false, the functions and the enums are macros in `macros_public.hpp`, which every file including `cglfl.hpp` has to preprocess.
+        // If true, they are inline functions and `inline constexpr` constants in `inline_api.hpp`, which can be precompiled,
+        // and `cglfl.cppm` is generated, which exports everything as a C++20 module.
+        // The macros are then only available from `macros_shim.hpp`, which is included if `CGLFL_MACRO_SHIM` is defined.
+        bool inline_api = 0;
+
+        // If true, the functions and the enums are also split into a header per version (`cglfl_generated/versions/gl3.3.hpp`, which includes the older versions),
+        // and a header per extension (`cglfl_generated/extensions/GL_KHR_debug.hpp`). The function slots stay the same, so the headers can be mixed freely.
+        // `cglfl.hpp` still includes all of them through `cglfl_generated/all.hpp`, unless `CGLFL_NO_UMBRELLA_HEADER` is defined.
+        bool split_headers = 0;
+
+        // Function names and how many times they're called, e.g. from a profiler, see `LoadCallCounts()`.
+        // If not empty, the most called functions get the first slots in `cglfl::context`, so their pointers share as few cache lines as possible.
+        // Only the slots are affected, everything else is generated the same way.
+        std::vector<std::pair<std::string, std::uint64_t>> call_counts;
+
+        // Function name patterns and sync classes, see `LoadSyncClasses()`. Checked before the built-in patterns, the first match wins.
+        // The sync class tells the debug layer which calls can make the CPU wait for the GPU, see `cglfl::debug::sync_class`.
+        std::vector<std::pair<std::string, std::string>> sync_classes;
+    };
+
+    // Reads the call counts for `GenerateOptions::call_counts` from a file, with a function name and a count on each line, e.g. `glDrawArrays 1200`.
+    // Empty lines and lines starting with `#` are ignored.
+    std::vector<std::pair<std::string, std::uint64_t>> LoadCallCounts(const std::string &file_name);
+
+    // Reads the overrides for `GenerateOptions::sync_classes` from a file, with a function name and a sync class on each line, e.g. `glGetIntegerv none`.
+    // A name ending with `*` matches any suffix. The classes are `none`, `query`, `readback`, `wait`, `map` and `map_range`.
+    // Empty lines and lines starting with `#` are ignored.
+    std::vector<std::pair<std::string, std::string>> LoadSyncClasses(const std::string &file_name);
+
+    // Where to look for the functions that an application uses, so that only those are generated.
+    struct UsageOptions
+    {
+        // Source files, or directories that are searched recursively for C and C++ sources.
+        // Anything that looks like a function name counts, e.g. `glDrawArrays`, even in comments and strings.
+        std::vector<std::string> sources;
+        std::vector<std::string> symbol_files; // Function names separated by whitespace. Lines starting with `#` are ignored.
+        std::vector<std::string> keep; // Used even if not found, e.g. the functions that are only called through the pointers in `cglfl::context`.
+    };
+
+    // Returns the names of the used functions, sorted. Those can include some names that aren't functions.
+    std::vector<std::string> FindUsedFunctions(const UsageOptions &options);
+
+    class Registry;
+    struct BatchEntry;
+
+    // Selects, generates and writes all configurations in parallel.
+    // A failing configuration doesn't stop the others. Returns false if any of them failed.
+    bool GenerateBatch(const Registry &registry, std::vector<BatchEntry> &entries, int thread_count = DefaultThreadCount(), const GenerateOptions &options = {});
+
+    // A selected API version and profile, and a set of extensions.
+    // Keeps its registry alive.
+    class Configuration
+    {
+        friend class Registry;
+        friend bool GenerateBatch(const Registry &, std::vector<BatchEntry> &, int, const GenerateOptions &);
+        std::shared_ptr<const impl::Configuration> data;
+
+      public:
+        Configuration();
+
+        // The directory that the generated files go to, e.g. `include/cglfl_gl4.6_compat`.
+        std::string OutputDir() const;
+
+        // The command line parameters that select this configuration.
+        std::string CommandLine() const;
+    };
+
+    struct GeneratedFile
+    {
+        std::string name; // Including `Configuration::OutputDir()`.
+        std::string contents;
+    };
+
+    class Registry
+    {
+        friend bool GenerateBatch(const Registry &, std::vector<BatchEntry> &, int, const GenerateOptions &);
+        std::shared_ptr<const impl::Registry> data;
+
+      public:
+        // An empty registry, can't be used until something is assigned to it.
+        Registry();
+
+        // Parses `options.xml_file`, or loads it from the cache.
+        static Registry Load(const LoadOptions &options = {});
+
+        // In the order they're listed in `gl.xml`, grouped by API.
+        std::vector<VersionInfo> Versions() const;
+
+        // Sorted by name.
+        std::vector<std::string> Extensions() const;
+
+        // Only the extensions supported by the API and profile of `config`, which must be selected from this registry. Sorted by name.
+        std::vector<std::string> Extensions(const Configuration &config) const;
+
+        // `params` are the same as the command line parameters of `cglfl_generate`:
+        // a version, a profile (if the version needs one), then any number of extensions supported by that version and profile.
+        // If `used_functions` isn't null, the rest of the functions are dropped, see `FindUsedFunctions()`.
+        // The functions that the runtime calls itself, such as `glGetError`, are always kept. Enums are never dropped.
+        Configuration Select(const std::vector<std::string> &params, const std::vector<std::string> *used_functions = nullptr) const;
+
+        // Generates the files for `config` into `files`, reusing the existing elements and their buffers if possible.
+        void Generate(const Configuration &config, std::vector<GeneratedFile> &files, const GenerateOptions &options = {}) const;
+    };
+
+    // Writes the files, creating the directories as needed.
+    // The files that already have the same contents are left untouched, to avoid rebuilding the code that includes them.
+    // The generated files that an earlier run left next to them, but that these options no longer produce, are removed.
+    void WriteFiles(const std::vector<GeneratedFile> &files, std::ostream *log = nullptr);
+
+    struct BatchEntry
+    {
+        std::vector<std::string> params; // See `Registry::Select()`.
+        const std::vector<std::string> *used_functions = nullptr; // Same. Must stay alive until `GenerateBatch()` returns.
+        std::string description; // Identifies the entry in the messages, e.g. `line 42`.
+
+        // Filled by `GenerateBatch()`:
+        std::string log;
+        std::string error; // Empty on success.
+    };
+
+    // Diagnostics.
+
+    // Selects the scanning kernels used by the lexer. Returns false if they don't exist or aren't supported by the CPU.
+    bool SetScanKernels(std::string_view name);
+
+    // Makes sure all supported scanning kernels, and the parallel lexer, produce the same tokens. Prints the results to `log`.
+    bool CheckScanKernels(const LoadOptions &options, std::ostream &log);
+
+    // Per-stage timing and memory usage.
+    namespace profile
+    {
+        // Start recording the stages. If `allocation_count` is specified, it should return the total number of allocations so far.
+        void Enable(std::uint64_t (*allocation_count)() = nullptr);
+        bool IsEnabled();
+
+        struct Stage
+        {
+            std::string name;
+            bool finished = 0; // If false, the stage is still running, and the numbers are meaningless.
+            double wall_ms = 0;
+            double cpu_ms = 0; // Process-wide, since some stages can run in parallel.
+            std::uint64_t allocations = 0; // Also process-wide. Zero if `Enable()` didn't receive a counter.
+            std::uint64_t peak_rss_kib = 0; // The high-water mark at the end of the stage.
+        };
+
+        // Returns the stages recorded so far, in the order they were started.
+        std::vector<Stage> Stages();
+
+        // Forgets the recorded stages, and restarts the total time. Must not be called while any stages are running.
+        void Clear();
+
+        // Prints a table of all stages to `out`, and writes the same data to `json_file_name` as JSON.
+        void Report(std::ostream &out, const std::string &json_file_name);
+    }
+}
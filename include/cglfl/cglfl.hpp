@@ -20,6 +20,8 @@ namespace cglfl
 {
     using function_loader_t = std::function<void *(const char *)>;
 
+    // The functions below load either all of the requested pointers, or none of them.
+
     // Loads all function pointers with the provided loader (excluding extensions).
     // Returns `true` on success.
     bool load(function_loader_t loader, bool throw_on_failure = true);
@@ -28,9 +30,18 @@ namespace cglfl
     // Returns `true` on success.
     bool load_extension(function_loader_t loader, std::string extension, bool throw_on_failure = true);
 
-    // Calls `load`, then `load_extension` for all known extensions.
+    // Calls `load`, then `load_extension` for all known extensions, stopping at the first failure.
     bool load_all(function_loader_t loader, bool throw_on_failure = true);
 
+    // Resolves `count` names at once, writing a pointer for each of them to `pointers`, or null if the function is missing.
+    // Useful if the platform can resolve a list of names faster than one name at a time.
+    using batch_function_loader_t = std::function<void(const char *const *names, void **pointers, std::size_t count)>;
+
+    // Same as above, but with a batch loader, which is called at most once. `load_all_batch` requests all names in a single call.
+    bool load_batch(batch_function_loader_t loader, bool throw_on_failure = true);
+    bool load_extension_batch(batch_function_loader_t loader, std::string extension, bool throw_on_failure = true);
+    bool load_all_batch(batch_function_loader_t loader, bool throw_on_failure = true);
+
     // Holds function pointers.
     struct context
     {
@@ -76,6 +87,75 @@ namespace cglfl
         // If a error occus, calls `error_handler_func`.
         void check_errors_now();
 
+        // Sync points are the calls that can make the CPU wait for the GPU. The generator assigns a class to each function, see `--sync-classes`.
+        enum class sync_class : std::uint8_t
+        {
+            none,
+            query,     // Reads the state, e.g. `glGet*` or `glIs*`. Some drivers have to flush or wait for the pending commands first.
+            readback,  // Reads the data produced by the GPU, e.g. `glReadPixels`, `glGetBufferSubData` or `glGetQueryObject*`.
+            wait,      // Waits for the GPU, e.g. `glFinish` or `glClientWaitSync`.
+            map,       // Maps a buffer, waiting until the GPU stops using it.
+            map_range, // Same, unless `GL_MAP_UNSYNCHRONIZED_BIT` is set in the last parameter, e.g. `glMapBufferRange`.
+        };
+        // Returns the sync class of the function in slot `i`.
+        sync_class get_sync_class(int i);
+        // Returns the name of a sync class, e.g. `query`.
+        const char *sync_class_name(sync_class c);
+
+        // Enables counting the sync points, per frame and per call site.
+        // Only the calls going through the debug hooks are counted, so the `glGetError` calls made by `check_errors` aren't.
+        extern bool count_sync_points; // Disabled by default.
+        // When counting the sync points, also measures how long they take.
+        extern bool time_sync_points; // Disabled by default.
+        // Call this once per frame, to get the per-frame numbers in the report.
+        void sync_next_frame();
+        // Uses `log` to print the sync point counts: the totals, per class, per frame, and for the `max_call_sites` busiest call sites.
+        void sync_report(int max_call_sites = 20);
+        // Forgets the counts.
+        void sync_reset();
+
+        namespace impl
+        {
+            template <typename T> std::uint64_t sync_param_value(const T &param)
+            {
+                if constexpr (std::is_integral_v<T>)
+                    return std::uint64_t(param);
+                else
+                    return 0;
+            }
+
+            void sync_begin(int i, const char *location, std::uint64_t last_param);
+
+            // The call site recorded by `CGLFL_DEBUG_WITH_CALL_SITE` for the duration of a call, or null.
+            inline thread_local const char *call_site = nullptr;
+
+            struct call_site_scope
+            {
+                const char *previous;
+
+                call_site_scope(const char *location) : previous(call_site) {call_site = location;}
+                call_site_scope(const call_site_scope &) = delete;
+                call_site_scope &operator=(const call_site_scope &) = delete;
+                ~call_site_scope() {call_site = previous;}
+            };
+
+            inline const char *call_site_or(const char *location)
+            {
+                return call_site ? call_site : location;
+            }
+        }
+
+        // Used by `CGLFL_DEBUG_SYNC_PRE` and `CGLFL_DEBUG_SYNC_POST`. `location` must be a string literal, it identifies the call site.
+        template <typename ...P> void sync_begin(int i, const char *location, const P &... params)
+        {
+            if (!count_sync_points)
+                return;
+            std::uint64_t last_param = 0;
+            ((last_param = impl::sync_param_value(params)), ...);
+            impl::sync_begin(i, location, last_param);
+        }
+        void sync_end();
+
         // Converts various things to strings for logging purposes.
         template <typename T>
         std::string to_string(const T &object)
@@ -134,3 +214,8 @@ namespace cglfl
         }
     }
 }
+
+// If the headers were generated with `--inline-api`, the functions and enums are declared here, since they need `cglfl::context`.
+#ifdef CGLFL_INLINE_API
+#include <cglfl_generated/inline_api.hpp>
+#endif
@@ -20,5 +20,17 @@
 // #define CGLFL_DEBUG_PRE(i, func, ret, n, param_names, params) ...
 // #define CGLFL_DEBUG_POST(i, func, ret, n, param_names, params) ...
 
+// If the headers were generated with `--inline-api`, the debug mode wraps each function in a function-like macro, to report the locations of the calls.
+// Define this if the macros get in the way, e.g. if the same names are used for something else. The locations then point to `inline_api.hpp`.
+// #define CGLFL_NO_DEBUG_CALL_SITES
+
 // Override function call macro. Use with care.
 // #define CGLFL_CALL ...
+
+// If the headers were generated with `--inline-api`, also define the functions and enums as macros, as they are by default.
+// #define CGLFL_MACRO_SHIM
+
+// If the headers were generated with `--split-headers`, don't declare everything in `cglfl.hpp`.
+// Include the needed headers from `cglfl_generated/versions/` and `cglfl_generated/extensions/` instead.
+// This can also be defined in individual files, before including any of the headers. Can't be used with `CGLFL_MACRO_SHIM`.
+// #define CGLFL_NO_UMBRELLA_HEADER
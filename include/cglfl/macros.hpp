@@ -27,10 +27,12 @@
 
 #ifndef CGLFL_DEBUG_PRE
 #  define CGLFL_DEBUG_PRE(i, func, ret, n, param_names, params) \
-    CGLFL_DEBUG_PRINT_PARAMS(i, func, ret, n, param_names, params)
+    CGLFL_DEBUG_PRINT_PARAMS(i, func, ret, n, param_names, params) \
+    CGLFL_DEBUG_SYNC_PRE(i, func, ret, n, param_names, params)
 #endif
 #ifndef CGLFL_DEBUG_POST
 #  define CGLFL_DEBUG_POST(i, func, ret, n, param_names, params) \
+    CGLFL_DEBUG_SYNC_POST(i, func, ret, n, param_names, params) \
     CGLFL_DEBUG_PRINT_RET(i, func, ret, n, param_names, params) \
     CGLFL_DEBUG_CHECK_ERRORS(i, func, ret, n, param_names, params)
 #endif
@@ -39,7 +41,7 @@
     if (::cglfl::debug::log_calls) \
     { \
         ::cglfl::debug::log(#func); \
-        ::cglfl::debug::log("    :: at " __FILE__ " : " CGLFL_IMPL_STR(__LINE__)); \
+        ::cglfl::debug::log(std::string("    :: at ") + CGLFL_DEBUG_CALL_SITE); \
         CGLFL_IMPL_FOR_EACH(CGLFL_DEBUG_PRINT_PARAM, n, CGLFL_IMPL_IDENTITY param_names) \
     }
 #define CGLFL_DEBUG_PRINT_RET(i, func, ret, n, param_names, params) \
@@ -52,6 +54,22 @@
     if (::cglfl::debug::check_errors) \
         ::cglfl::debug::check_errors_now();
 
+// See `cglfl::debug::count_sync_points`. Those don't share any state, so either one can be removed from the hooks.
+#define CGLFL_DEBUG_SYNC_PRE(i, func, ret, n, param_names, params) \
+    ::cglfl::debug::sync_begin(i, CGLFL_DEBUG_CALL_SITE CGLFL_IMPL_FOR_EACH(CGLFL_DEBUG_SYNC_PARAM, n, CGLFL_IMPL_IDENTITY param_names));
+#define CGLFL_DEBUG_SYNC_POST(i, func, ret, n, param_names, params) \
+    ::cglfl::debug::sync_end();
+
+#define CGLFL_DEBUG_SYNC_PARAM(param) , param
+
+// The location of the call, as a string literal. With `--inline-api`, it's recorded by `CGLFL_DEBUG_WITH_CALL_SITE`, since `__LINE__` in the hooks
+// would point to `inline_api.hpp`. The code that includes the headers through the generated module still gets those locations.
+#define CGLFL_DEBUG_CALL_SITE ::cglfl::debug::impl::call_site_or(__FILE__ " : " CGLFL_IMPL_STR(__LINE__))
+
+// `inline_api.hpp` wraps each function in this in the debug mode, unless `CGLFL_NO_DEBUG_CALL_SITES` is defined.
+#define CGLFL_DEBUG_WITH_CALL_SITE(func, ...) \
+    (void(::cglfl::debug::impl::call_site_scope(__FILE__ " : " CGLFL_IMPL_STR(__LINE__))), func(__VA_ARGS__))
+
 #define CGLFL_DEBUG_PRINT_PARAM(param) \
     ::cglfl::debug::log("    " #param " = " + CGLFL_DEBUG_TO_STRING(param));
 
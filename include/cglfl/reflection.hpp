@@ -0,0 +1,104 @@
+#pragma once
+
+// CGLFL (configurable OpenGL function loader)
+//   by Egor Mikhailov <blckcat@inbox.ru>
+// License: zlib
+
+// Describes the parameters of all functions, for tracing and capturing tools built on top of `CGLFL_CALL` or `CGLFL_DEBUG_PRE`/`CGLFL_DEBUG_POST`.
+// The tables are indexed by the function slots, which are passed to those macros as `i`.
+// Also converts the enum values back to names, see `cglfl::enum_name()`.
+
+#include <cstdint>
+
+#include "cglfl.hpp"
+
+namespace cglfl::reflection
+{
+    enum class param_kind : std::uint8_t
+    {
+        scalar,      // A number, a boolean, or a callback.
+        enumeration, // `GLenum` or `GLbitfield`.
+        handle,      // An object name (guessed from the parameter name), or an opaque handle such as `GLsync`.
+        in_pointer,  // Points to the data that the function reads.
+        out_pointer, // Points to the data that the function writes (and sometimes also reads).
+        string,      // A `const GLchar *`. Null-terminated, unless the function has a length parameter for it.
+    };
+
+    struct param_info
+    {
+        param_kind kind;
+        std::uint16_t group; // An index in `group_names`, or 0 if none.
+        std::uint16_t len; // An offset in `len_strings` of the size of the pointed array, e.g. `count*4` or `COMPSIZE(pname)`, or 0 if unknown.
+    };
+
+    struct function_info
+    {
+        std::uint32_t first_param : 24; // An index in `params`.
+        std::uint32_t param_count : 8;
+    };
+
+    struct enum_entry
+    {
+        std::uint32_t value;
+        std::uint32_t name; // An offset in `enum_name_strings`.
+    };
+}
+
+// `group_names`, `len_strings`, `params`, `functions`, and for the enums, `enum_name_strings`, `enum_entries` and `enum_group_ranges`.
+// `enum_entries` has several tables sorted by value, the group ID `g` selects the range from `enum_group_ranges[g]` to `enum_group_ranges[g+1]`.
+// Group 0 has all constants. Each value is listed once per table, see `cglfl::enum_name()`.
+#include <cglfl_generated/reflection.hpp>
+
+namespace cglfl::reflection
+{
+    // The parameters of the function in slot `i`.
+    inline const param_info *function_params(int i)
+    {
+        return params + functions[i].first_param;
+    }
+
+    // The group name of a parameter, such as `TextureTarget`, or null if none.
+    inline const char *group_name(const param_info &param)
+    {
+        return param.group ? group_names[param.group] : nullptr;
+    }
+
+    // The size expression of an array parameter, or null if unknown.
+    inline const char *len_string(const param_info &param)
+    {
+        return param.len ? len_strings + param.len : nullptr;
+    }
+
+    // Finds a value in the enum table for a group with a binary search. Returns null if not found.
+    constexpr const enum_entry *find_enum(std::uint32_t value, int group_id)
+    {
+        const enum_entry *begin = enum_entries + enum_group_ranges[group_id];
+        const enum_entry *end = enum_entries + enum_group_ranges[group_id + 1];
+        while (begin != end)
+        {
+            const enum_entry *middle = begin + (end - begin) / 2;
+            if (middle->value == value)
+                return middle;
+            if (middle->value < value)
+                begin = middle + 1;
+            else
+                end = middle;
+        }
+        return nullptr;
+    }
+}
+
+namespace cglfl
+{
+    // Returns the name of an enum constant, e.g. `GL_TEXTURE_2D`, or null if there's no constant with this value.
+    // `group_id` is `reflection::param_info::group` of the parameter that the value was passed to. Since many constants share the values,
+    // it helps to find the right one. If the group doesn't have this value, or if `group_id` is 0, all constants are searched.
+    // If there are several constants with the value, prefers the ones that aren't from extensions, then the shortest ones.
+    constexpr const char *enum_name(std::uint32_t value, int group_id = 0)
+    {
+        const reflection::enum_entry *entry = group_id != 0 ? reflection::find_enum(value, group_id) : nullptr;
+        if (!entry)
+            entry = reflection::find_enum(value, 0);
+        return entry ? reflection::enum_name_strings + entry->name : nullptr;
+    }
+}
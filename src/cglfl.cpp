@@ -4,95 +4,177 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstdint>
 #include <cstdio>
 #include <exception>
+#include <map>
+#include <mutex>
 #include <stdexcept>
+#include <string>
 #include <utility>
 #include <vector>
 
+// The macros recording the call sites would clash with `macros_shim.hpp` below, and there are no calls to record here anyway.
+#ifndef CGLFL_NO_DEBUG_CALL_SITES
+#define CGLFL_NO_DEBUG_CALL_SITES
+#endif
+
 #include <cglfl/cglfl.hpp>
 #include <cglfl_generated/macros_internal.hpp>
+#ifdef CGLFL_SPLIT_HEADERS
+// Everything is needed below, even if the umbrella header is disabled. Must precede the macros, if they're separate.
+#include <cglfl_generated/all.hpp>
+#endif
+#ifdef CGLFL_INLINE_API
+// The macros are needed below, to call `glGetError` without the debug wrapper, and to check which enums exist.
+#include <cglfl_generated/macros_shim.hpp>
+#endif
 
 namespace cglfl
 {
-    static bool load_func(int index, std::vector<int> &rollback_list, function_loader_t &loader, const char *name)
+    // See `macros_internal.hpp`.
+    static constexpr char load_names[] = CGLFL_LOAD_NAMES;
+    static constexpr std::array<std::uint32_t, CGLFL_FUNC_COUNT> load_name_offsets = {CGLFL_LOAD_NAME_OFFSETS};
+    static constexpr std::array<CGLFL_LOAD_SLOT_TYPE, CGLFL_LOAD_SLOT_COUNT> load_slots = {CGLFL_LOAD_SLOTS};
+    static constexpr std::array<CGLFL_LOAD_RANGE_TYPE, CGLFL_EXT_COUNT + 2> load_ranges = {CGLFL_LOAD_RANGES};
+
+    #define CGLFL_X(ext) #ext,
+    static constexpr std::array<const char *, CGLFL_EXT_COUNT> ext_names = {CGLFL_EXTS(CGLFL_X)};
+    #undef CGLFL_X
+
+    // Loads the lists from `first` to `last - 1` in `load_slots` (0 for the primary functions, or the extension index plus 1), with a single call to `loader`.
+    // Each list is loaded completely or not at all. Stops at the first list that can't be loaded, and returns its index. Returns `last` on success.
+    static int load_lists(int first, int last, const batch_function_loader_t &loader)
     {
-        auto &ptr = context_pointer->functions[index];
-        if (ptr)
-            return true;
+        // The index of each slot in the batch, or -1. Allocated once per thread, and only the used entries are reset,
+        // so that loading a small extension doesn't cost as much as loading everything.
+        static thread_local std::vector<int> batch_indices;
+        if (batch_indices.empty())
+            batch_indices.resize(CGLFL_FUNC_COUNT, -1);
 
-        ptr = loader(name);
-        if (!ptr)
-            return false;
+        std::vector<int> batch_slots;
+        struct reset_batch_indices
+        {
+            const std::vector<int> &slots;
+            ~reset_batch_indices()
+            {
+                for (int slot : slots)
+                    batch_indices[slot] = -1;
+            }
+        };
+        reset_batch_indices reset{batch_slots};
 
-        rollback_list.push_back(index);
-        return true;
+        std::vector<const char *> names;
+        for (int i = load_ranges[first]; i < load_ranges[last]; i++)
+        {
+            int slot = load_slots[i];
+            if (context_pointer->functions[slot] || batch_indices[slot] != -1)
+                continue;
+
+            batch_indices[slot] = names.size();
+            batch_slots.push_back(slot);
+            names.push_back(load_names + load_name_offsets[slot]);
+        }
+
+        std::vector<void *> pointers(names.size());
+        if (names.size() > 0)
+            loader(names.data(), pointers.data(), names.size());
+
+        for (int list = first; list < last; list++)
+        {
+            for (int i = load_ranges[list]; i < load_ranges[list + 1]; i++)
+            {
+                int slot = load_slots[i];
+                if (!context_pointer->functions[slot] && !pointers[batch_indices[slot]])
+                    return list;
+            }
+
+            for (int i = load_ranges[list]; i < load_ranges[list + 1]; i++)
+            {
+                int slot = load_slots[i];
+                if (!context_pointer->functions[slot])
+                    context_pointer->functions[slot] = pointers[batch_indices[slot]];
+            }
+        }
+
+        return last;
     }
 
-    #undef CGLFL_CALL
-    #define CGLFL_CALL(i, func, ret, n, param_names, params) && load_func(i, rollback_list, loader, #func)
-    bool load(function_loader_t loader, bool throw_on_failure)
+    // Reports that a list in `load_slots` couldn't be loaded. Returns false.
+    static bool load_failed(int list, bool throw_on_failure)
     {
-        std::vector<int> rollback_list;
-        rollback_list.reserve(CGLFL_PRIMARY_FUNC_COUNT);
-
-        bool ok = true CGLFL_PRIMARY_FUNCS;
-        if (!ok)
+        if (throw_on_failure)
         {
-            for (int index : rollback_list)
-                context_pointer->functions[index] = nullptr;
-            if (throw_on_failure)
+            if (list == 0)
                 throw std::runtime_error("cglfl: Unable to load primary OpenGL functions.");
-            return false;
+            else
+                throw std::runtime_error(std::string("cglfl: Unable to load OpenGL functions for extension: ") + ext_names[list - 1]);
         }
+        return false;
+    }
 
+    // Calls `loader` for one name at a time. Stops at the first missing function, since the rest of its list won't be loaded anyway.
+    static batch_function_loader_t make_batch_loader(function_loader_t loader)
+    {
+        return [loader = std::move(loader)](const char *const *names, void **pointers, std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                pointers[i] = loader(names[i]);
+                if (!pointers[i])
+                    break;
+            }
+        };
+    }
+
+    bool load(function_loader_t loader, bool throw_on_failure)
+    {
+        return load_batch(make_batch_loader(std::move(loader)), throw_on_failure);
+    }
+
+    bool load_batch(batch_function_loader_t loader, bool throw_on_failure)
+    {
+        if (load_lists(0, 1, loader) != 1)
+            return load_failed(0, throw_on_failure);
         return true;
     }
 
     bool load_extension(function_loader_t loader, std::string extension, bool throw_on_failure)
     {
-        using func_pair_t = std::pair<std::string, bool (*)(function_loader_t &, bool)>;
-        static std::array<func_pair_t, CGLFL_EXT_COUNT> ext_funcs
-        {
-            #define CGLFL_X(ext) func_pair_t{#ext, [](function_loader_t &loader, bool throw_on_failure) -> bool  \
-            {                                                                                                    \
-                std::vector<int> rollback_list;                                                                  \
-                rollback_list.reserve(CGLFL_IMPL_CAT(CGLFL_EXT_FUNC_COUNT_, ext));                               \
-                bool ok = true CGLFL_IMPL_CAT(CGLFL_EXT_FUNCS_, ext);                                            \
-                if (!ok)                                                                                         \
-                {                                                                                                \
-                    for (int index : rollback_list)                                                              \
-                        context_pointer->functions[index] = nullptr;                                             \
-                    if (throw_on_failure)                                                                        \
-                        throw std::runtime_error("cglfl: Unable to load OpenGL functions for extension: " #ext); \
-                    return false;                                                                                \
-                }                                                                                                \
-                return true;                                                                                     \
-            }},
-            CGLFL_EXTS(CGLFL_X)
-            #undef CGLFL_X
-        };
+        return load_extension_batch(make_batch_loader(std::move(loader)), std::move(extension), throw_on_failure);
+    }
 
-        auto it = std::lower_bound(ext_funcs.begin(), ext_funcs.end(), extension, [](const func_pair_t &a, const std::string &b)
+    bool load_extension_batch(batch_function_loader_t loader, std::string extension, bool throw_on_failure)
+    {
+        auto it = std::lower_bound(ext_names.begin(), ext_names.end(), extension, [](const char *a, const std::string &b)
         {
-            return a.first < b;
+            return a < b;
         });
 
-        if (it == ext_funcs.end() || it->first != extension)
+        if (it == ext_names.end() || *it != extension)
         {
             if (throw_on_failure)
                 throw std::runtime_error("cglfl: Unknown extension: " + extension);
             return false;
         }
 
-        return it->second(loader, throw_on_failure);
+        int list = it - ext_names.begin() + 1;
+        if (load_lists(list, list + 1, loader) != list + 1)
+            return load_failed(list, throw_on_failure);
+        return true;
     }
 
     bool load_all(function_loader_t loader, bool throw_on_failure)
     {
-        #define CGLFL_X(ext) && load_extension(loader, #ext, throw_on_failure)
-        return load(loader, throw_on_failure) CGLFL_EXTS(CGLFL_X);
-        #undef CGLFL_X
+        return load_all_batch(make_batch_loader(std::move(loader)), throw_on_failure);
+    }
+
+    bool load_all_batch(batch_function_loader_t loader, bool throw_on_failure)
+    {
+        if (int list = load_lists(0, CGLFL_EXT_COUNT + 1, loader); list != CGLFL_EXT_COUNT + 1)
+            return load_failed(list, throw_on_failure);
+        return true;
     }
 
     #ifndef CGLFL_NO_DEFAULT_CONTEXT
@@ -179,5 +261,196 @@ namespace cglfl
             #define CGLFL_CALL CGLFL_CALL_DEFAULT
             return glGetError();
         }
+
+        sync_class get_sync_class(int i)
+        {
+            static const auto classes = []
+            {
+                std::array<sync_class, CGLFL_FUNC_COUNT> ret{};
+                #define CGLFL_SYNC_POINT(i, func, c) ret[i] = sync_class::c;
+                CGLFL_SYNC_POINTS(CGLFL_SYNC_POINT)
+                #undef CGLFL_SYNC_POINT
+                return ret;
+            }();
+            return classes[i];
+        }
+
+        const char *sync_class_name(sync_class c)
+        {
+            switch (c)
+            {
+                case sync_class::none:      return "none";
+                case sync_class::query:     return "query";
+                case sync_class::readback:  return "readback";
+                case sync_class::wait:      return "wait";
+                case sync_class::map:       return "map";
+                case sync_class::map_range: return "map_range";
+            }
+            return "???";
+        }
+
+        // Returns the function name in slot `i`, if it's a sync point.
+        static const char *sync_point_name(int i)
+        {
+            static const auto names = []
+            {
+                std::array<const char *, CGLFL_FUNC_COUNT> ret{};
+                #define CGLFL_SYNC_POINT(i, func, c) ret[i] = #func;
+                CGLFL_SYNC_POINTS(CGLFL_SYNC_POINT)
+                #undef CGLFL_SYNC_POINT
+                return ret;
+            }();
+            return names[i] ? names[i] : "???";
+        }
+
+        bool count_sync_points = false;
+        bool time_sync_points = false;
+
+        namespace impl
+        {
+            struct sync_stats
+            {
+                std::uint64_t count = 0;
+                double total_ms = 0, max_ms = 0;
+
+                void add(double ms)
+                {
+                    count++;
+                    total_ms += ms;
+                    max_ms = std::max(max_ms, ms);
+                }
+            };
+
+            struct sync_state
+            {
+                std::mutex mutex;
+                sync_stats total;
+                std::array<sync_stats, 6> classes;
+                std::map<std::pair<const char *, int>, sync_stats> call_sites; // Call site and function slot.
+                std::uint64_t frames = 0, frame_count = 0, max_frame_count = 0, counted_in_frames = 0;
+            };
+
+            static sync_state &get_sync_state()
+            {
+                static sync_state ret;
+                return ret;
+            }
+
+            // The sync point that is being called on this thread.
+            struct pending_sync_point
+            {
+                int slot = -1;
+                const char *location = nullptr;
+                std::chrono::steady_clock::time_point start;
+            };
+            static thread_local pending_sync_point pending;
+
+            void sync_begin(int i, const char *location, std::uint64_t last_param)
+            {
+                sync_class c = get_sync_class(i);
+                if (c == sync_class::none)
+                    return;
+                #ifdef GL_MAP_UNSYNCHRONIZED_BIT
+                if (c == sync_class::map_range && (last_param & GL_MAP_UNSYNCHRONIZED_BIT))
+                    return;
+                #else
+                (void)last_param;
+                #endif
+
+                pending.slot = i;
+                pending.location = location;
+                if (time_sync_points)
+                    pending.start = std::chrono::steady_clock::now();
+            }
+        }
+
+        void sync_end()
+        {
+            auto &pending = impl::pending;
+            if (pending.slot == -1)
+                return;
+
+            double ms = 0;
+            if (time_sync_points)
+                ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - pending.start).count();
+
+            auto &state = impl::get_sync_state();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.total.add(ms);
+            state.classes[int(get_sync_class(pending.slot))].add(ms);
+            state.call_sites[{pending.location, pending.slot}].add(ms);
+            state.frame_count++;
+
+            pending.slot = -1;
+        }
+
+        void sync_next_frame()
+        {
+            auto &state = impl::get_sync_state();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.frames++;
+            state.max_frame_count = std::max(state.max_frame_count, state.frame_count);
+            state.counted_in_frames += state.frame_count;
+            state.frame_count = 0;
+        }
+
+        void sync_report(int max_call_sites)
+        {
+            auto &state = impl::get_sync_state();
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            char buffer[256];
+            auto StatsString = [&](const impl::sync_stats &stats)
+            {
+                if (time_sync_points)
+                    std::snprintf(buffer, sizeof buffer, "%llu calls, %.3f ms total, %.3f ms max", (unsigned long long)stats.count, stats.total_ms, stats.max_ms);
+                else
+                    std::snprintf(buffer, sizeof buffer, "%llu calls", (unsigned long long)stats.count);
+                return std::string(buffer);
+            };
+
+            log("Sync points: " + StatsString(state.total));
+            if (state.frames > 0)
+            {
+                std::snprintf(buffer, sizeof buffer, "    per frame: %.1f on average, %llu at most, over %llu frames",
+                    double(state.counted_in_frames) / state.frames, (unsigned long long)state.max_frame_count, (unsigned long long)state.frames);
+                log(buffer);
+            }
+            for (std::size_t i = 1; i < state.classes.size(); i++)
+            {
+                if (state.classes[i].count > 0)
+                    log(std::string("    ") + sync_class_name(sync_class(i)) + ": " + StatsString(state.classes[i]));
+            }
+
+            std::vector<std::pair<const std::pair<const char *, int>, impl::sync_stats> *> call_sites;
+            for (auto &call_site : state.call_sites)
+                call_sites.push_back(&call_site);
+            std::sort(call_sites.begin(), call_sites.end(), [](const auto *a, const auto *b)
+            {
+                if (time_sync_points && a->second.total_ms != b->second.total_ms)
+                    return a->second.total_ms > b->second.total_ms;
+                return a->second.count > b->second.count;
+            });
+            if (int(call_sites.size()) > max_call_sites)
+                call_sites.resize(max_call_sites);
+
+            if (call_sites.size() > 0)
+                log(time_sync_points ? "Call sites, by time:" : "Call sites, by count:");
+            for (const auto *call_site : call_sites)
+            {
+                const auto &[location, slot] = call_site->first;
+                log("    " + std::string(sync_point_name(slot)) + " at " + location + ": " + StatsString(call_site->second));
+            }
+        }
+
+        void sync_reset()
+        {
+            auto &state = impl::get_sync_state();
+            std::lock_guard<std::mutex> lock(state.mutex);
+            state.total = {};
+            state.classes = {};
+            state.call_sites.clear();
+            state.frames = state.frame_count = state.max_frame_count = state.counted_in_frames = 0;
+        }
     }
 }